@@ -0,0 +1,20 @@
+// include/console.h - line commands on the serial port
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+#include "device_settings.h"
+
+// Commands, one per line:
+//   metrics                 timings and heap (metrics.h)
+//   trace                   latency of the last readings, sensor to
+//                           display (trace_report.h)
+//   config, wifi, url, ...  the settings commands of device_settings.h;
+//                           edits collect in a copy of settings until
+//                           "save" stores them and restarts, "reset"
+//                           erases them (built-in defaults) and restarts
+void consoleBegin(const DeviceSettings& settings);
+// Reads pending serial input; call every loop() pass
+void consolePoll();
+
+#endif // CONSOLE_H
@@ -0,0 +1,14 @@
+// include/device_id.h - id and network name of this unit
+#ifndef DEVICE_ID_H
+#define DEVICE_ID_H
+
+#include <Arduino.h>
+
+// From the eFuse MAC: unique on the LAN, and its low bytes differ between
+// units (peer packets, see peer_link.h)
+uint32_t deviceId();
+// "gluco-watch-<low 24 bits of deviceId() in hex>": the mDNS name, the
+// setup network and the latency report node
+const char* deviceName();
+
+#endif // DEVICE_ID_H
@@ -0,0 +1,28 @@
+// include/display_backend.h - display driver selected at compile time
+#ifndef DISPLAY_BACKEND_H
+#define DISPLAY_BACKEND_H
+
+#define DISPLAY_TM1637 1  // 4-digit segment display (default)
+#define DISPLAY_SSD1306 2 // 128x64 I2C OLED: value, trend arrow, sparkline
+#define DISPLAY_EPAPER 3  // SPI e-paper: holds its image unpowered, partial refresh
+
+// Pick with -DGLUCOSE_DISPLAY=DISPLAY_SSD1306 (see the envs in
+// platformio.ini, which add the driver library)
+#ifndef GLUCOSE_DISPLAY
+#define GLUCOSE_DISPLAY DISPLAY_TM1637
+#endif
+
+#if GLUCOSE_DISPLAY == DISPLAY_TM1637
+#include "display_tm1637.h"
+typedef Tm1637Backend DisplayBackend;
+#elif GLUCOSE_DISPLAY == DISPLAY_SSD1306
+#include "display_ssd1306.h"
+typedef Ssd1306Backend DisplayBackend;
+#elif GLUCOSE_DISPLAY == DISPLAY_EPAPER
+#include "display_epaper.h"
+typedef EpaperBackend DisplayBackend;
+#else
+#error "GLUCOSE_DISPLAY must be DISPLAY_TM1637, DISPLAY_SSD1306 or DISPLAY_EPAPER"
+#endif
+
+#endif // DISPLAY_BACKEND_H
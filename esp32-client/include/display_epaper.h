@@ -0,0 +1,77 @@
+// include/display_epaper.h - SPI e-paper backend (GxEPD2) with partial refresh
+#ifndef DISPLAY_EPAPER_H
+#define DISPLAY_EPAPER_H
+
+#include <GxEPD2_BW.h>
+#include "display_gfx.h"
+#include "display_renderer.h"
+
+// Any black/white GxEPD2 panel class; the layout follows its size
+#ifndef EPAPER_PANEL
+#define EPAPER_PANEL GxEPD2_213_BN // 2.13" 250x122 (Waveshare / WeAct V4)
+#endif
+// SPI on free pins (the board's default SCK, GPIO 7, drives the yellow LED)
+#ifndef EPAPER_SCK
+#define EPAPER_SCK 35
+#endif
+#ifndef EPAPER_MOSI
+#define EPAPER_MOSI 33
+#endif
+#ifndef EPAPER_CS
+#define EPAPER_CS 37
+#endif
+#ifndef EPAPER_DC
+#define EPAPER_DC 39
+#endif
+#ifndef EPAPER_RST
+#define EPAPER_RST 40
+#endif
+#ifndef EPAPER_BUSY
+#define EPAPER_BUSY 38
+#endif
+// Partial refreshes leave a faint ghost of what was there; every this
+// many a full refresh (a second of flashing) clears it
+#ifndef EPAPER_FULL_REFRESH_EVERY
+#define EPAPER_FULL_REFRESH_EVERY 30
+#endif
+
+// Users on the screen at once, one row each; a row of the 122 pixels of
+// the default panel stays readable down to a quarter
+static const uint8_t EPAPER_SLOTS = 4;
+
+// Refreshes only the window around the changed regions (value, trend,
+// stale marker, sparkline), then powers the panel down: between readings
+// it draws no current and keeps the image. A stale value carries a "?"
+// instead of blinking. Every user has a row of their own, numbered when
+// there are more than one, so nothing cycles and an unchanged screen is
+// never refreshed.
+class EpaperBackend : public DisplayRenderer<EpaperBackend, EPAPER_SLOTS> {
+public:
+  static const uint8_t REGIONS = DISPLAY_REGION_ALL;
+  static const bool BLINKS_STALE = false;
+  static const bool KEEPS_IMAGE = true;
+  static const bool SPARKLINE = true;
+  static const uint32_t TASK_STACK = 4096;
+
+  EpaperBackend();
+
+private:
+  friend class DisplayRenderer<EpaperBackend, EPAPER_SLOTS>;
+
+  void start(bool keepImage, uint8_t slots);
+  void drawView(const DisplayView& view, uint8_t dirty, uint8_t slot);
+  void drawLabel(uint8_t number);
+  void drawBlank();
+  void power(bool on);
+
+  // Sets the window of the next refresh: a full refresh when one is due
+  // (returns true), r otherwise
+  bool window(const GfxRect& r);
+
+  GxEPD2_BW<EPAPER_PANEL, EPAPER_PANEL::HEIGHT> _epd;
+  GfxLayout _layouts[EPAPER_SLOTS];
+  uint8_t _slots;
+  uint16_t _partials; // since the last full refresh
+};
+
+#endif // DISPLAY_EPAPER_H
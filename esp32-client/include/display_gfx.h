@@ -0,0 +1,36 @@
+// include/display_gfx.h - DisplayView drawing for the pixel backends (Adafruit_GFX)
+#ifndef DISPLAY_GFX_H
+#define DISPLAY_GFX_H
+
+#include <Adafruit_GFX.h>
+#include "display_view.h"
+
+struct GfxRect {
+  int16_t x, y, w, h;
+};
+
+// Value, trend arrow and stale marker side by side on top, the sparkline
+// below. Edges fall on multiples of 8 pixels, the granularity of e-paper
+// partial windows.
+struct GfxLayout {
+  GfxRect value, trend, stale, spark;
+};
+
+// In area (edges on multiples of 8); one too low for a readable
+// sparkline leaves it out and gives the whole height to the value
+GfxLayout gfxLayout(const GfxRect& area);
+// The index-th of count rows of equal height across a canvas, one per
+// user when they are all on the screen at once
+GfxRect gfxRow(int16_t width, int16_t height, uint8_t index, uint8_t count);
+// Smallest rectangle holding the given DISPLAY_REGION_* bits
+GfxRect gfxBounds(const GfxLayout& layout, uint8_t regions);
+
+// Draws all of view in color onto a cleared canvas; the backend decides
+// which part of it goes out to the panel. A number other than 0 goes
+// small into the corner of the value, the user's in place of a label.
+void gfxDrawView(Adafruit_GFX& gfx, const GfxLayout& layout, const DisplayView& view, uint16_t color,
+                 uint8_t number = 0);
+// "U n" across the whole canvas
+void gfxDrawLabel(Adafruit_GFX& gfx, uint8_t number, uint16_t color);
+
+#endif // DISPLAY_GFX_H
@@ -0,0 +1,123 @@
+// include/display_renderer.h - what every display backend shares (CRTP base)
+#ifndef DISPLAY_RENDERER_H
+#define DISPLAY_RENDERER_H
+
+#include <Arduino.h>
+#include "display_view.h"
+#include "metrics.h"
+
+// A backend derives from DisplayRenderer<Backend, SLOTS> and provides
+//   void start(bool keepImage, uint8_t slots)
+//                               bus and panel set-up; keepImage after a
+//                               deep sleep wake-up; slots in use (users)
+//   void drawView(const DisplayView& view, uint8_t dirty, uint8_t slot)
+//                               dirty: the DISPLAY_REGION_* that changed
+//   void drawLabel(uint8_t number)
+//   void drawBlank()
+//   void power(bool on)
+// and the constants
+//   REGIONS       DISPLAY_REGION_* it draws; changes to the others are
+//                 not sent at all
+//   BLINKS_STALE  a stale value blinks (see displayTask() in main.cpp),
+//                 otherwise drawView() marks it
+//   KEEPS_IMAGE   what is shown survives power(false)
+//   SPARKLINE     views need a sparkline (sparklineFrom())
+//   TASK_STACK    bytes of the display task's stack
+// SLOTS is how many users' views the screen holds side by side. With 1
+// (CYCLES_USERS) the display task shows the users one after another,
+// each behind a label; otherwise every user has a slot of their own and
+// only a view that changed is drawn.
+// The calls are bound at compile time, so there is no vtable on the
+// render path and only the selected driver is linked.
+template <typename Backend, uint8_t N = 1> class DisplayRenderer {
+public:
+  static const uint8_t SLOTS = N;
+  static const bool CYCLES_USERS = N == 1;
+
+  void begin(bool keepImage, uint8_t users) {
+    _slots = users < N ? users : N;
+    if (_slots == 0) {
+      _slots = 1;
+    }
+    self().start(keepImage, _slots);
+    _shown = Shown::Unknown;
+    for (uint8_t i = 0; i < N; ++i) {
+      _known[i] = false;
+    }
+  }
+
+  // The buses are slow and e-paper redraws whatever it is sent, so only
+  // what differs from the shown view goes out (force redraws all of it)
+  void show(const DisplayView& view, uint8_t slot = 0, bool force = false) {
+    if (slot >= _slots) {
+      return;
+    }
+    if (_shown != Shown::View) {
+      // a label, blank or unknown screen: no slot is on it
+      for (uint8_t i = 0; i < N; ++i) {
+        _drawn[i] = false;
+      }
+      _shown = Shown::View;
+    }
+    uint8_t dirty = DISPLAY_REGION_ALL;
+    if (!force && _drawn[slot]) {
+      dirty = displayDirty(_views[slot], view) & Backend::REGIONS;
+    }
+    _views[slot] = view;
+    _known[slot] = true;
+    if (dirty == 0) {
+      return;
+    }
+    PhaseTimer timer(Phase::Render);
+    self().drawView(view, dirty, slot);
+    _drawn[slot] = true;
+  }
+
+  // "U  n" before the n-th (1-based) user's value
+  void label(uint8_t number) {
+    if (_shown == Shown::Label && _label == number) {
+      return;
+    }
+    PhaseTimer timer(Phase::Render);
+    self().drawLabel(number);
+    _shown = Shown::Label;
+    _label = number;
+  }
+
+  void blank() {
+    if (_shown == Shown::Blank) {
+      return;
+    }
+    PhaseTimer timer(Phase::Render);
+    self().drawBlank();
+    _shown = Shown::Blank;
+  }
+
+  // Off for the sleep of LOW_POWER_BLANK_DISPLAY; whatever comes after
+  // power(true) is drawn in full unless the backend kept its image
+  void setPower(bool on) {
+    self().power(on);
+    if (!Backend::KEEPS_IMAGE) {
+      _shown = Shown::Unknown;
+    }
+  }
+
+protected:
+  // The last view shown in slot, nullptr before the first; for backends
+  // that redraw the whole screen now and then
+  const DisplayView* slotView(uint8_t slot) const { return _known[slot] ? &_views[slot] : nullptr; }
+
+private:
+  enum class Shown : uint8_t { Unknown, View, Label, Blank };
+
+  Backend& self() { return static_cast<Backend&>(*this); }
+
+  Shown _shown = Shown::Unknown;
+  uint8_t _slots = 1;
+  DisplayView _views[N];
+  bool _known[N] = {}; // _views[i] holds a view
+  bool _drawn[N] = {}; // and it is on the screen
+  uint8_t _label = 0;
+};
+
+#endif // DISPLAY_RENDERER_H
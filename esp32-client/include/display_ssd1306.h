@@ -0,0 +1,46 @@
+// include/display_ssd1306.h - 128x64 SSD1306 I2C OLED backend
+#ifndef DISPLAY_SSD1306_H
+#define DISPLAY_SSD1306_H
+
+#include <Adafruit_SSD1306.h>
+#include "display_gfx.h"
+#include "display_renderer.h"
+
+// The TM1637's pins by default, so an OLED drops into the same wiring
+#ifndef OLED_SDA
+#define OLED_SDA 33
+#endif
+#ifndef OLED_SCL
+#define OLED_SCL 35
+#endif
+#ifndef OLED_ADDRESS
+#define OLED_ADDRESS 0x3C
+#endif
+
+// Value, trend arrow and a sparkline of the last SPARKLINE_POINTS
+// readings. The frame buffer goes out whole (1 KiB, ~25 ms at 400 kHz),
+// so the dirty regions only decide whether anything is sent.
+class Ssd1306Backend : public DisplayRenderer<Ssd1306Backend> {
+public:
+  static const uint8_t REGIONS = DISPLAY_REGION_ALL;
+  static const bool BLINKS_STALE = true;
+  static const bool KEEPS_IMAGE = true; // display off keeps its RAM
+  static const bool SPARKLINE = true;
+  static const uint32_t TASK_STACK = 4096;
+
+  Ssd1306Backend();
+
+private:
+  friend class DisplayRenderer<Ssd1306Backend>;
+
+  void start(bool keepImage, uint8_t slots);
+  void drawView(const DisplayView& view, uint8_t dirty, uint8_t slot);
+  void drawLabel(uint8_t number);
+  void drawBlank();
+  void power(bool on);
+
+  Adafruit_SSD1306 _oled;
+  GfxLayout _layout;
+};
+
+#endif // DISPLAY_SSD1306_H
@@ -0,0 +1,38 @@
+// include/display_tm1637.h - 4-digit TM1637 segment display backend
+#ifndef DISPLAY_TM1637_H
+#define DISPLAY_TM1637_H
+
+#include <TM1637Display.h>
+#include "display_renderer.h"
+
+#ifndef TM1637_CLK
+#define TM1637_CLK 35
+#endif
+#ifndef TM1637_DIO
+#define TM1637_DIO 33
+#endif
+
+// Shows the precomputed DisplayFrame; the trend arrow is part of it
+class Tm1637Backend : public DisplayRenderer<Tm1637Backend> {
+public:
+  static const uint8_t REGIONS = DISPLAY_REGION_VALUE | DISPLAY_REGION_TREND;
+  static const bool BLINKS_STALE = true;
+  static const bool KEEPS_IMAGE = false;
+  static const bool SPARKLINE = false;
+  static const uint32_t TASK_STACK = 2048;
+
+  Tm1637Backend();
+
+private:
+  friend class DisplayRenderer<Tm1637Backend>;
+
+  void start(bool keepImage, uint8_t slots);
+  void drawView(const DisplayView& view, uint8_t dirty, uint8_t slot);
+  void drawLabel(uint8_t number);
+  void drawBlank();
+  void power(bool on);
+
+  TM1637Display _display;
+};
+
+#endif // DISPLAY_TM1637_H
@@ -0,0 +1,59 @@
+// include/glucose_stream.h - Firebase RTDB Server-Sent Events listener
+#ifndef GLUCOSE_STREAM_H
+#define GLUCOSE_STREAM_H
+
+#include <Arduino.h>
+#include "https_session.h"
+#include "glucose_reading.h"
+
+// Holds an RTDB REST stream (Accept: text/event-stream) open on the given
+// session and parses put/patch/keep-alive events incrementally as bytes
+// arrive, so the device learns about a new reading as soon as the
+// ingestor writes it instead of polling.
+class GlucoseStream {
+public:
+  GlucoseStream(HttpsSession& session, const char* url);
+
+  bool open();
+  void close();
+  bool connected();
+  // Consumes whatever is buffered on the socket without blocking. Returns
+  // true and fills reading when an event carried a glucose value, and
+  // publishedAt with its fetched_at_unix_ms in s (0 if the event had none).
+  bool poll(GlucoseReading& reading, uint32_t& publishedAt);
+  // Idles up to timeoutMs, returning early as soon as data is available.
+  void waitForData(unsigned long timeoutMs);
+
+private:
+  static const size_t BUFFER_SIZE = 768;
+  static const size_t NAME_SIZE = 16;
+  // RTDB sends keep-alive every 30 s; treat a longer silence as a dead link
+  static const unsigned long IDLE_TIMEOUT_MS = 90000;
+
+  void resetParser();
+  bool feed(char c, GlucoseReading& reading);
+  bool processLine(GlucoseReading& reading);
+  bool dispatch(GlucoseReading& reading);
+
+  HttpsSession& _session;
+  const char* _url;
+  bool _open;
+  bool _chunked;
+  unsigned long _lastActivityMs;
+
+  // chunked transfer decoding
+  enum ChunkState { CHUNK_SIZE, CHUNK_DATA, CHUNK_TRAILER };
+  ChunkState _chunkState;
+  size_t _chunkRemaining;
+
+  // SSE event assembly: completed data bytes live at _buf[0.._dataLen),
+  // the line being read follows them at _buf[_dataLen.._len)
+  char _buf[BUFFER_SIZE];
+  size_t _dataLen;
+  size_t _len;
+  bool _overflow;
+  char _name[NAME_SIZE];
+  uint32_t _publishedAt; // of the last dispatched reading
+};
+
+#endif // GLUCOSE_STREAM_H
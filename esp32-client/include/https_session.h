@@ -0,0 +1,50 @@
+// include/https_session.h - long-lived HTTPS connection to the RTDB host
+#ifndef HTTPS_SESSION_H
+#define HTTPS_SESSION_H
+
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+
+// 1 = skip server certificate verification (debugging only, e.g. behind
+// a TLS-intercepting proxy). By default the server must chain up to one
+// of the pinned roots in rtdb_trust.h.
+#ifndef TLS_INSECURE
+#define TLS_INSECURE 0
+#endif
+
+// Keeps one TLS socket open between requests (HTTP/1.1 keep-alive), so
+// periodic fetches only pay the TLS handshake when the server or WiFi
+// drops the connection. Reconnect happens lazily on the next request.
+//
+// Usage per request: begin(url) -> GET() or PUT() -> read http() -> end().
+class HttpsSession {
+public:
+  HttpsSession(uint16_t timeoutMs = 5000);
+
+  bool begin(const char* url);
+  // Sends the GET; if a reused socket turned out to be closed by the peer
+  // while idle, reconnects once and retries. Connecting is done here
+  // rather than inside HTTPClient so DNS, handshake and time to first
+  // byte show up separately in metrics.h.
+  int GET();
+  // Same, for a PUT of body (RTDB: replaces the node at the URL)
+  int PUT(const char* body, size_t len);
+  HTTPClient& http() { return _http; }
+  // Finishes the request but keeps the socket open for the next one.
+  void end();
+  // Drops the socket (e.g. after WiFi loss); the next begin() reconnects.
+  void reset();
+
+private:
+  bool connect();
+  int send(const char* body, size_t len); // GET when body is null
+
+  WiFiClientSecure _client;
+  HTTPClient _http;
+  uint16_t _timeoutMs;
+  bool _configured;
+  char _host[64]; // of the last begin() URL
+  uint16_t _port;
+};
+
+#endif // HTTPS_SESSION_H
@@ -0,0 +1,22 @@
+// include/lan_push.h - readings pushed straight from the ingestor on the LAN
+#ifndef LAN_PUSH_H
+#define LAN_PUSH_H
+
+#include <WebServer.h>
+#include "glucose_reading.h"
+
+// Runs in the task that calls localServerHandle(); returns false if uid
+// is not one of the watched users
+typedef bool (*LanPushHandler)(const char* uid, const GlucoseReading& reading);
+
+// POST /push?uid=<id> with the compact record as the body, byte for byte
+// what RTDB serves for users/<id>/compact.json ("01000036673119C7", see
+// compact_reading.h), and the shared secret in an X-Push-Token header.
+// Answers 204 when the reading was taken, 401 for a wrong token, 400 for
+// a malformed record and 404 for a user this device doesn't watch.
+//
+// Plain HTTP: the token keeps other LAN hosts from injecting readings but
+// is visible to anyone who can sniff the network.
+void lanPushRoutes(WebServer& server, const char* token, LanPushHandler handler);
+
+#endif // LAN_PUSH_H
@@ -0,0 +1,28 @@
+// include/led_engine.h - alert LED patterns from the LEDC peripheral and an esp_timer
+#ifndef LED_ENGINE_H
+#define LED_ENGINE_H
+
+#include <Arduino.h>
+#include "led_state.h"
+
+// The LEDs hang off LEDC channels (5 kHz PWM, so brightness is a duty
+// cycle) and the blink and fade patterns of led_state.h are stepped by a
+// periodic esp_timer. Nothing runs in loop(): a blocked HTTPS request or a
+// WiFi reconnect doesn't stop a blink, and a steady colour costs no CPU
+// at all (the timer only runs while a pattern is animated).
+
+// Attaches the three colour LEDs and a mirror LED (the board's own, lit
+// with whichever colour is lit) to LEDC; all start off
+void ledEngineBegin(uint8_t redPin, uint8_t yellowPin, uint8_t greenPin, uint8_t mirrorPin);
+// Starts the state's pattern from its beginning, unless it is already shown
+void ledEngineShow(const LedState& state);
+// 1-100 %, applied to every pattern (see ledBrightnessAt())
+void ledEngineSetBrightness(uint8_t percent);
+
+// Sleep stops the LEDC clock, so before it the pattern is stopped and the
+// lit LED is left at full level (which gpio_hold_en() can then keep
+// through deep sleep); ledEngineResume() picks the pattern up again
+void ledEngineSuspend();
+void ledEngineResume();
+
+#endif // LED_ENGINE_H
@@ -0,0 +1,14 @@
+// include/local_server.h - the device's HTTP server on the LAN
+#ifndef LOCAL_SERVER_H
+#define LOCAL_SERVER_H
+
+#include <WebServer.h>
+
+// One WebServer for every local endpoint (GET /metrics, POST /push);
+// features register their routes on the returned server. Requests are
+// served from localServerHandle(), i.e. in the caller's task.
+WebServer& localServerBegin(uint16_t port);
+// Call often (every loop() pass); no-op before localServerBegin()
+void localServerHandle();
+
+#endif // LOCAL_SERVER_H
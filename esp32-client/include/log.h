@@ -0,0 +1,61 @@
+// include/log.h - leveled serial logging that compiles out below LOG_LEVEL
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#define LOG_LEVEL_TRACE 5
+
+// Select with build_flags = -DLOG_LEVEL=LOG_LEVEL_DEBUG. Calls above the
+// level expand to nothing: no format string in flash, no formatting.
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 1 = format into a RAM ring buffer and let a low-priority task drain it
+// to Serial, so logging never waits for the UART. Lines that don't fit
+// are dropped (and counted) instead of blocking.
+#ifndef LOG_RING_BUFFER
+#define LOG_RING_BUFFER 0
+#endif
+#ifndef LOG_RING_BUFFER_SIZE
+#define LOG_RING_BUFFER_SIZE 2048
+#endif
+
+void logBegin(unsigned long baud);
+void logWrite(char level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+// Waits until buffered output has reached the UART (e.g. before sleeping)
+void logFlush();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logWrite('E', __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logWrite('W', __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logWrite('I', __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logWrite('D', __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_TRACE
+#define LOG_TRACE(...) logWrite('T', __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+
+#endif // LOG_H
@@ -0,0 +1,28 @@
+// include/low_power.h - sleep between fetches with RTC-retained bookkeeping
+#ifndef LOW_POWER_H
+#define LOW_POWER_H
+
+#include <Arduino.h>
+
+#define LOW_POWER_OFF 0
+#define LOW_POWER_LIGHT 1 // RAM, GPIO levels and WiFi association are kept
+#define LOW_POWER_DEEP 2  // only RTC memory survives; wake-up restarts setup()
+
+// Current draw used for the average-current estimate (mA). The defaults are
+// rough ESP32-S2 mini + TM1637 figures; override with values measured on
+// your own unit, e.g. build_flags = -DLOW_POWER_AWAKE_MA=72.0
+#ifndef LOW_POWER_AWAKE_MA
+#define LOW_POWER_AWAKE_MA 75.0f
+#endif
+#ifndef LOW_POWER_SLEEP_MA
+#define LOW_POWER_SLEEP_MA 1.5f
+#endif
+
+bool lowPowerWokeFromDeepSleep();
+// Sleeps for ms minus the time spent awake in this cycle. Light sleep
+// returns; deep sleep does not (the chip reboots into setup()).
+void lowPowerSleep(unsigned long intervalMs, int mode);
+// Prints duty cycle and estimated average current since power-on.
+void lowPowerReport();
+
+#endif // LOW_POWER_H
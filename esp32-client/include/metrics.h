@@ -0,0 +1,48 @@
+// include/metrics.h - per-phase timings and heap low-water marks
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Phases of a fetch, each with its own LatencyHistogram. WiFiClientSecure
+// does TCP connect and TLS handshake in one call, so Connect covers both.
+// Parse includes the socket reads when the JSON is parsed from the stream.
+enum class Phase : uint8_t {
+  Dns,       // host lookup before a new connection
+  Connect,   // TCP connect + TLS handshake
+  FirstByte, // request sent until the response headers are in
+  Body,      // reading the response body (compact record, history)
+  Parse,     // decoding the body
+  Render,    // drawing in the display task (bus transfer, e-paper refresh)
+  COUNT
+};
+
+void metricsRecord(Phase phase, uint32_t us);
+// Updates the free heap / largest free block minimums. Called from the
+// network task at its low points: once per loop() pass, after each TLS
+// connect and response, and while a body is parsed or an image inflated.
+// Lows inside the TLS handshake itself are only in the allocator's own
+// minimum (ESP.getMinFreeHeap(), reported next to it).
+void metricsSampleHeap();
+
+// Human-readable table (serial command "metrics", see console.h)
+void metricsDump(Print& out);
+// Prometheus text format (GET /metrics)
+void metricsPrometheus(Print& out);
+
+// Adds GET /metrics to the local server (see local_server.h)
+void metricsRoutes(WebServer& server);
+
+// Records the lifetime of the scope as one sample of a phase
+class PhaseTimer {
+public:
+  explicit PhaseTimer(Phase phase) : _phase(phase), _startUs(micros()) {}
+  ~PhaseTimer() { metricsRecord(_phase, micros() - _startUs); }
+
+private:
+  Phase _phase;
+  uint32_t _startUs;
+};
+
+#endif // METRICS_H
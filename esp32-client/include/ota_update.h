@@ -0,0 +1,46 @@
+// include/ota_update.h - firmware updates pulled over HTTPS, with rollback
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <Arduino.h>
+#include "ota_manifest.h"
+
+// Version of this build; an update is installed when the manifest's
+// version is higher. Release builds set it, e.g. -DFIRMWARE_VERSION=8
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION 1
+#endif
+// Hours between manifest checks (the first one runs once the clock has
+// synced). The manifest is a few hundred bytes; only a new version
+// downloads the image.
+#ifndef OTA_CHECK_INTERVAL_H
+#define OTA_CHECK_INTERVAL_H 6
+#endif
+// A new image is on trial until it shows a reading. It is rolled back to
+// the previous one (still in the other OTA slot) if that takes longer
+// than OTA_TRIAL_MIN minutes awake, or more than OTA_TRIAL_BOOTS boots:
+// a crash loop, or in deep-sleep mode, wake-ups without a reading.
+#ifndef OTA_TRIAL_MIN
+#define OTA_TRIAL_MIN 10
+#endif
+#ifndef OTA_TRIAL_BOOTS
+#define OTA_TRIAL_BOOTS 5
+#endif
+
+// Call early in setup(): counts the boot of an image on trial, rolls
+// back (and restarts) once it ran out of boots
+void otaBegin();
+// A reading arrived: the running image is good, the trial ends
+void otaConfirm();
+// Call from loop(): rolls back a trial that ran out of time
+void otaPoll();
+// True when the periodic manifest check is due (WiFi up, clock synced)
+bool otaCheckDue();
+// Fetches the manifest and, if it announces a newer version, downloads
+// the image (gzip-compressed or plain) into the other OTA slot and
+// restarts into it. Returns only when there was nothing to install or
+// the download failed. Opens its own TLS connections: close the others
+// first, the download needs the heap.
+void otaCheck(const char* manifestUrl);
+
+#endif // OTA_UPDATE_H
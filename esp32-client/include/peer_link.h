@@ -0,0 +1,38 @@
+// include/peer_link.h - readings shared between the displays of one LAN
+#ifndef PEER_LINK_H
+#define PEER_LINK_H
+
+#include <Arduino.h>
+#include "glucose_reading.h"
+#include "peer_packet.h"
+
+// Multicast group and port of the peer packets (peer_packet.h); the
+// group is in the organization-local scope, so routers don't forward it
+#ifndef PEER_GROUP
+#define PEER_GROUP 239, 255, 71, 87
+#endif
+#ifndef PEER_PORT
+#define PEER_PORT 4787
+#endif
+
+// Runs in the task that calls peerPoll(); return false if the uid is not
+// watched here or the reading is not newer than what it has
+typedef bool (*PeerReadingHandler)(const char* uid, const GlucoseReading& reading, uint32_t publishedAt);
+
+// Joins the group (again after every IP change) and advertises the
+// device over mDNS as gluco-watch-<id>.local with a _glucowatch._udp
+// service, so peers and the ingestor's LAN push can find it by name.
+// Packets are signed with key (kept by the caller; every display needs
+// the same one). Without a key the device stays out of the group and
+// polls the cloud on its own.
+void peerBegin(PeerReadingHandler handler, const char* key);
+// Receives pending packets and sends the periodic hello; call often
+void peerPoll();
+// Multicasts a reading this device got from the cloud or a LAN push
+void peerBroadcast(const char* uid, const GlucoseReading& reading, uint32_t publishedAt);
+// True while no live peer has a lower id: this device polls the cloud
+bool peerIsLeader();
+// Live peers heard in the last PeerTable::TIMEOUT_MS
+size_t peerCount();
+
+#endif // PEER_LINK_H
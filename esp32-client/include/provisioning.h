@@ -0,0 +1,34 @@
+// include/provisioning.h - setup page on a SoftAP when no known network is in reach
+#ifndef PROVISIONING_H
+#define PROVISIONING_H
+
+#include <Arduino.h>
+#include "device_settings.h"
+
+// How long the setup network stays up before the device restarts and
+// tries its known networks again (e.g. the router was only rebooting)
+#ifndef PROVISIONING_TIMEOUT_S
+#define PROVISIONING_TIMEOUT_S 300
+#endif
+// How long a cold boot keeps retrying the known networks before it opens
+// the setup network: after a power cut the router usually comes up later
+// than the display. Without saved networks the setup network opens at once.
+#ifndef PROVISIONING_WAIT_S
+#define PROVISIONING_WAIT_S 180
+#endif
+// Password of the setup network; empty = open. An open setup network only
+// adds WiFi networks: the RTDB url and the push token decide where the
+// readings come from, so they can only be changed behind a password (or
+// over the serial console).
+#ifndef PROVISIONING_AP_PASS
+#define PROVISIONING_AP_PASS ""
+#endif
+
+// Opens the setup network "gluco-watch-<id>" with a captive portal (every
+// DNS name answers with the device, so phones pop the page up): add a
+// WiFi network and, with PROVISIONING_AP_PASS set, change the RTDB url or
+// the push token. Saving stores the settings (settings_store.h) and
+// restarts; so does the timeout. Does not return.
+void provisioningRun(const DeviceSettings& settings);
+
+#endif // PROVISIONING_H
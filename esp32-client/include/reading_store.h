@@ -0,0 +1,20 @@
+// include/reading_store.h - ReadingCache copies in NVS, for a boot after power loss
+#ifndef READING_STORE_H
+#define READING_STORE_H
+
+#include <Arduino.h>
+#include "reading_cache.h"
+
+// NVS is wear-levelled, but each write still costs a flash entry per 32
+// bytes; the copy is refreshed at most this often (the RTC copy follows
+// every reading)
+#ifndef READING_STORE_INTERVAL_MIN
+#define READING_STORE_INTERVAL_MIN 30
+#endif
+
+// One blob per user slot; false if there is none of the right size (the
+// content is checked by readingCacheRestore())
+bool readingStoreLoad(size_t user, ReadingCache& cache);
+bool readingStoreSave(size_t user, const ReadingCache& cache);
+
+#endif // READING_STORE_H
@@ -0,0 +1,16 @@
+// include/rtdb_trust.h - pinned root CAs of the RTDB host
+#ifndef RTDB_TRUST_H
+#define RTDB_TRUST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Google Trust Services roots (and GlobalSign Root CA, which cross-signs
+// GTS Root R1) as a precomputed x509_crt_bundle in flash: subject and
+// public key per root, no PEM to decode or certificate to parse at
+// handshake time. Regenerate with tools/gen_trust_bundle.py when Google
+// changes its roots (GlobalSign Root CA expires in January 2028).
+extern const uint8_t RTDB_CA_BUNDLE[];
+extern const size_t RTDB_CA_BUNDLE_SIZE;
+
+#endif // RTDB_TRUST_H
@@ -0,0 +1,18 @@
+// include/settings_store.h - DeviceSettings persisted in NVS
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include "device_settings.h"
+
+// One blob read: the stored settings if there are any of the current
+// layout, else false and settings is left alone (the built-in defaults)
+bool settingsLoad(DeviceSettings& settings);
+bool settingsSave(const DeviceSettings& settings);
+// Back to the built-in defaults on the next boot
+void settingsErase();
+// The settings as the "config" command shows them; passwords and the
+// token are masked
+void settingsPrint(const DeviceSettings& settings, Print& out);
+
+#endif // SETTINGS_STORE_H
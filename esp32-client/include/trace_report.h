@@ -0,0 +1,30 @@
+// include/trace_report.h - reports of the per-reading latencies (reading_trace.h)
+#ifndef TRACE_REPORT_H
+#define TRACE_REPORT_H
+
+#include <Arduino.h>
+#include "https_session.h"
+#include "reading_trace.h"
+
+// Minutes between latency reports in the log (and RTDB); 0 leaves only
+// the serial command "trace"
+#ifndef TRACE_REPORT_MIN
+#define TRACE_REPORT_MIN 60
+#endif
+// 1 = also PUT each report to users/<id>/latency/<deviceName()>.json (device_id.h), next to
+// the readings. The database rules must let the display write that node.
+#ifndef TRACE_POST
+#define TRACE_POST 0
+#endif
+
+// The windows stay owned by the caller (one per user, same order as ids)
+void traceBegin(const char* const* userIds, const TraceWindow* windows, size_t users);
+// Percentiles of every stage, and of Receive per source (serial command
+// "trace", see console.h)
+void traceDump(Print& out);
+// One line per user and stage with readings
+void traceLog();
+// Stores user's report at url; true on a 2xx
+bool tracePost(HttpsSession& session, const char* url, size_t user, uint32_t at);
+
+#endif // TRACE_REPORT_H
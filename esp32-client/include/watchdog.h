@@ -0,0 +1,22 @@
+// include/watchdog.h - task watchdog over the network task
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+
+// A network task that doesn't feed the watchdog for this long is taken as
+// hung (an HTTPS call or WiFi wait that never returns) and the chip
+// resets with a panic, so the reason is in the next boot's log. Well
+// above the longest bounded wait: a TLS handshake plus a 5 s timeout,
+// one WiFi association attempt.
+#ifndef WATCHDOG_TIMEOUT_S
+#define WATCHDOG_TIMEOUT_S 60
+#endif
+
+// Puts the calling task (loop()) under the task watchdog
+void watchdogBegin();
+// Call at least every WATCHDOG_TIMEOUT_S from the watched task: once per
+// loop() pass and inside every wait loop that can outlast it
+void watchdogFeed();
+
+#endif // WATCHDOG_H
@@ -0,0 +1,54 @@
+// include/wifi_connect.h - fast WiFi association with an NVS-cached AP
+#ifndef WIFI_CONNECT_H
+#define WIFI_CONNECT_H
+
+#include <Arduino.h>
+
+struct WifiCred {
+  const char* ssid;
+  const char* pass;
+};
+
+// Also cache the DHCP lease (IP, gateway, mask, DNS) and reuse it as a
+// static config on the fast path, skipping DHCP. Off by default because a
+// reused address can clash if the router hands it to someone else.
+#ifndef WIFI_CACHE_IP
+#define WIFI_CACHE_IP 0
+#endif
+// After this many failed attempts in a row on one network because it's
+// out of reach or refuses us, wifiReconnect() moves on to the next one
+#ifndef WIFI_ROAM_AFTER
+#define WIFI_ROAM_AFTER 3
+#endif
+
+// A change of the link, recorded by the WiFi event handler
+struct WifiLinkChange {
+  bool up;              // associated and got an IP
+  uint8_t reason;       // wifi_err_reason_t of a drop
+  unsigned long downMs; // how long the link was down, when up
+};
+
+// Connects to one of creds[]:
+// 1. the AP (BSSID + channel) that worked last time, read from NVS
+// 2. otherwise one scan, trying the known networks by RSSI, strongest first
+// The AP that succeeds is written back to NVS (only when it changed).
+// From then on the link is followed through WiFi.onEvent() and the core's
+// own auto-reconnect is off: reconnecting is up to wifiReconnect().
+bool wifiConnect(const WifiCred* creds, size_t count);
+
+// One reconnect attempt (returns at once; the outcome arrives as an
+// event): the same network, or the next one of creds[] once the current
+// one failed WIFI_ROAM_AFTER times as out of reach or refusing us
+void wifiReconnect(const WifiCred* creds, size_t count);
+
+// The newest link change since the last call; false when there was none.
+// A roam that worked is written to the NVS cache here.
+bool wifiTakeLinkChange(WifiLinkChange& change);
+// A change is waiting, so an idle wait can end early
+bool wifiLinkChangePending();
+
+// Waits for an association started by WiFi.begin()/WiFi.reconnect(),
+// blocked on the link event instead of polling the status
+bool waitForWifi(unsigned long timeoutMs);
+
+#endif // WIFI_CONNECT_H
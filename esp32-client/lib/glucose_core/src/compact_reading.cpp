@@ -0,0 +1,31 @@
+#include "compact_reading.h"
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+bool decodeCompactReading(const char* body, size_t len, GlucoseReading& out) {
+  if (len != COMPACT_BODY_SIZE || body[0] != '"' || body[len - 1] != '"') {
+    return false;
+  }
+  unsigned char record[COMPACT_RECORD_SIZE];
+  for (size_t i = 0; i < COMPACT_RECORD_SIZE; ++i) {
+    int hi = hexValue(body[1 + 2 * i]);
+    int lo = hexValue(body[2 + 2 * i]);
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+    record[i] = (unsigned char)(hi << 4 | lo);
+  }
+  if (record[0] != COMPACT_VERSION) {
+    return false;
+  }
+  uint16_t tenths = (uint16_t)(record[2] << 8 | record[3]);
+  out.mgdl = tenthsToMgdl(tenths);
+  out.timestamp = (uint32_t)record[4] << 24 | (uint32_t)record[5] << 16
+                  | (uint32_t)record[6] << 8 | (uint32_t)record[7];
+  return true;
+}
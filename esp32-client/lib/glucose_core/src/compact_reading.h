@@ -0,0 +1,20 @@
+// lib/glucose_core/src/compact_reading.h - decoder for the ingestor's compact record
+#ifndef COMPACT_READING_H
+#define COMPACT_READING_H
+
+#include <stddef.h>
+#include "glucose_reading.h"
+
+// users/{uid}/compact.json holds an 8-byte big-endian record, hex-encoded
+// as a JSON string ("01000036673119C7"):
+//   u8 version, u8 flags, u16 glucose in 0.1 mmol/L, u32 unix timestamp
+const unsigned char COMPACT_VERSION = 1;
+const size_t COMPACT_RECORD_SIZE = 8;
+// quotes + hex digits, i.e. the whole REST body
+const size_t COMPACT_BODY_SIZE = 2 + 2 * COMPACT_RECORD_SIZE;
+
+// Decodes a REST body; false for anything that is not a version 1 record
+// (e.g. "null" if the ingestor has not written one yet)
+bool decodeCompactReading(const char* body, size_t len, GlucoseReading& out);
+
+#endif // COMPACT_READING_H
@@ -0,0 +1,180 @@
+#include "device_settings.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// strlcpy() that refuses to truncate
+static bool copyString(char* dst, size_t size, const char* src) {
+  size_t len = strlen(src);
+  if (len >= size) {
+    return false;
+  }
+  memcpy(dst, src, len + 1);
+  return true;
+}
+
+static bool terminated(const char* s, size_t size) {
+  return memchr(s, '\0', size) != nullptr;
+}
+
+void settingsClear(DeviceSettings& settings) {
+  memset(&settings, 0, sizeof(settings));
+  settings.layout = SETTINGS_LAYOUT;
+}
+
+bool settingsAddWifi(DeviceSettings& settings, const char* ssid, const char* pass) {
+  if (ssid[0] == '\0' || strlen(ssid) >= SETTINGS_SSID_SIZE || strlen(pass) >= SETTINGS_PASS_SIZE) {
+    return false;
+  }
+  size_t i = 0;
+  while (i < settings.wifiCount && strcmp(settings.wifi[i].ssid, ssid) != 0) {
+    ++i;
+  }
+  if (i == SETTINGS_WIFI_MAX) {
+    return false;
+  }
+  copyString(settings.wifi[i].ssid, SETTINGS_SSID_SIZE, ssid);
+  copyString(settings.wifi[i].pass, SETTINGS_PASS_SIZE, pass);
+  if (i == settings.wifiCount) {
+    settings.wifiCount++;
+  }
+  return true;
+}
+
+bool settingsRemoveWifi(DeviceSettings& settings, size_t index) {
+  if (index >= settings.wifiCount) {
+    return false;
+  }
+  memmove(&settings.wifi[index], &settings.wifi[index + 1],
+          (settings.wifiCount - index - 1) * sizeof(WifiNetwork));
+  settings.wifiCount--;
+  memset(&settings.wifi[settings.wifiCount], 0, sizeof(WifiNetwork));
+  return true;
+}
+
+bool settingsSetUrl(DeviceSettings& settings, const char* url) {
+  size_t len = strlen(url);
+  while (len > 0 && url[len - 1] == '/') {
+    --len;
+  }
+  if (strncmp(url, "https://", 8) != 0 || len <= 8 || len >= SETTINGS_URL_SIZE) {
+    return false;
+  }
+  memcpy(settings.rtdbUrl, url, len);
+  settings.rtdbUrl[len] = '\0';
+  return true;
+}
+
+bool settingsSetToken(DeviceSettings& settings, const char* token) {
+  return token[0] != '\0' && copyString(settings.pushToken, SETTINGS_TOKEN_SIZE, token);
+}
+
+bool settingsValid(const DeviceSettings& settings) {
+  if (settings.layout != SETTINGS_LAYOUT || settings.wifiCount > SETTINGS_WIFI_MAX
+      || !terminated(settings.rtdbUrl, SETTINGS_URL_SIZE) || !terminated(settings.pushToken, SETTINGS_TOKEN_SIZE)
+      || strncmp(settings.rtdbUrl, "https://", 8) != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < settings.wifiCount; ++i) {
+    if (!terminated(settings.wifi[i].ssid, SETTINGS_SSID_SIZE)
+        || !terminated(settings.wifi[i].pass, SETTINGS_PASS_SIZE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The next word or "quoted value" from p into out; nullptr if there is
+// none or it doesn't fit, else where parsing continues
+static const char* nextToken(const char* p, char* out, size_t size) {
+  while (*p == ' ') {
+    ++p;
+  }
+  if (*p == '\0') {
+    return nullptr;
+  }
+  char end = ' ';
+  if (*p == '"') {
+    end = '"';
+    ++p;
+  }
+  size_t len = 0;
+  while (*p != '\0' && *p != end) {
+    if (len + 1 >= size) {
+      return nullptr;
+    }
+    out[len++] = *p++;
+  }
+  if (end == '"') {
+    if (*p != '"') {
+      return nullptr; // unterminated quote
+    }
+    ++p;
+  }
+  out[len] = '\0';
+  return p;
+}
+
+// No further arguments after p
+static bool atEnd(const char* p) {
+  return p[strspn(p, " ")] == '\0';
+}
+
+SettingsCommand settingsCommand(DeviceSettings& settings, const char* line) {
+  char word[8];
+  const char* p = nextToken(line, word, sizeof(word));
+  if (!p) {
+    return SettingsCommand::None;
+  }
+  if (strcmp(word, "config") == 0) {
+    return atEnd(p) ? SettingsCommand::Show : SettingsCommand::Invalid;
+  }
+  if (strcmp(word, "save") == 0) {
+    return atEnd(p) ? SettingsCommand::Save : SettingsCommand::Invalid;
+  }
+  if (strcmp(word, "reset") == 0) {
+    return atEnd(p) ? SettingsCommand::Reset : SettingsCommand::Invalid;
+  }
+
+  char value[SETTINGS_URL_SIZE + 1]; // the longest value, one over to catch overlong input
+  if (strcmp(word, "url") == 0 || strcmp(word, "token") == 0) {
+    bool url = word[0] == 'u';
+    p = nextToken(p, value, sizeof(value));
+    if (!p || !atEnd(p)) {
+      return SettingsCommand::Invalid;
+    }
+    bool ok = url ? settingsSetUrl(settings, value) : settingsSetToken(settings, value);
+    return ok ? SettingsCommand::Changed : SettingsCommand::Invalid;
+  }
+  if (strcmp(word, "wifi") != 0) {
+    return SettingsCommand::None;
+  }
+
+  p = nextToken(p, word, sizeof(word));
+  if (p && strcmp(word, "add") == 0) {
+    char ssid[SETTINGS_SSID_SIZE];
+    char pass[SETTINGS_PASS_SIZE] = "";
+    p = nextToken(p, ssid, sizeof(ssid));
+    if (!p) {
+      return SettingsCommand::Invalid;
+    }
+    if (!atEnd(p)) {
+      p = nextToken(p, pass, sizeof(pass));
+      if (!p || !atEnd(p)) {
+        return SettingsCommand::Invalid;
+      }
+    }
+    return settingsAddWifi(settings, ssid, pass) ? SettingsCommand::Changed : SettingsCommand::Invalid;
+  }
+  if (p && strcmp(word, "del") == 0) {
+    p = nextToken(p, value, sizeof(value));
+    if (!p || !atEnd(p)) {
+      return SettingsCommand::Invalid;
+    }
+    char* end;
+    unsigned long n = strtoul(value, &end, 10);
+    return *end == '\0' && n >= 1 && settingsRemoveWifi(settings, n - 1) ? SettingsCommand::Changed
+                                                                         : SettingsCommand::Invalid;
+  }
+  return SettingsCommand::Invalid;
+}
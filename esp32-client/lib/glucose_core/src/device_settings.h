@@ -0,0 +1,70 @@
+// lib/glucose_core/src/device_settings.h - runtime settings and their console commands
+#ifndef DEVICE_SETTINGS_H
+#define DEVICE_SETTINGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// WiFi networks the settings can hold (the built-in list from secrets.h
+// is only the default)
+#ifndef SETTINGS_WIFI_MAX
+#define SETTINGS_WIFI_MAX 8
+#endif
+
+// Bump when DeviceSettings changes; a stored blob of another layout is
+// ignored and the built-in defaults apply
+const uint16_t SETTINGS_LAYOUT = 1;
+const size_t SETTINGS_SSID_SIZE = 33;  // 32 bytes + NUL
+const size_t SETTINGS_PASS_SIZE = 64;  // WPA2 passphrase, 63 + NUL
+const size_t SETTINGS_URL_SIZE = 96;
+const size_t SETTINGS_TOKEN_SIZE = 48;
+
+struct WifiNetwork {
+  char ssid[SETTINGS_SSID_SIZE];
+  char pass[SETTINGS_PASS_SIZE]; // empty for an open network
+};
+
+// What differs between installations: kept as one NVS blob and read once
+// at boot, so nothing looks settings up at run time. Thresholds, cadence
+// and unit stay compile-time (glucose_config.h).
+struct DeviceSettings {
+  uint16_t layout;
+  uint8_t wifiCount;
+  WifiNetwork wifi[SETTINGS_WIFI_MAX];
+  char rtdbUrl[SETTINGS_URL_SIZE];        // https://<db>.firebasedatabase.app, no trailing slash
+  char pushToken[SETTINGS_TOKEN_SIZE];    // X-Push-Token of the LAN push
+};
+
+// Empty settings of the current layout
+void settingsClear(DeviceSettings& settings);
+// Adds a network, or sets the password of one already in the list; false
+// if the list is full or a value doesn't fit
+bool settingsAddWifi(DeviceSettings& settings, const char* ssid, const char* pass);
+// index as listed, from 0
+bool settingsRemoveWifi(DeviceSettings& settings, size_t index);
+// https only; a trailing slash is dropped
+bool settingsSetUrl(DeviceSettings& settings, const char* url);
+bool settingsSetToken(DeviceSettings& settings, const char* token);
+// A blob read back from flash: current layout, terminated strings
+bool settingsValid(const DeviceSettings& settings);
+
+enum class SettingsCommand : uint8_t {
+  None,    // not a settings command
+  Show,    // config
+  Changed, // edited in RAM; "save" stores it
+  Save,
+  Reset,
+  Invalid, // a settings command with bad arguments
+};
+
+// Applies one console line:
+//   config                        show the settings
+//   wifi add <ssid> [<password>]  quote values with spaces: wifi add "My Net" secret
+//   wifi del <n>                  n as shown by config, from 1
+//   url <https://...>             RTDB host
+//   token <secret>                LAN push token
+//   save                          store in NVS (read at the next boot)
+//   reset                         erase, back to the built-in defaults
+SettingsCommand settingsCommand(DeviceSettings& settings, const char* line);
+
+#endif // DEVICE_SETTINGS_H
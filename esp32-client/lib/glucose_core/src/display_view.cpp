@@ -0,0 +1,75 @@
+#include "display_view.h"
+
+#include <stdio.h>
+#include <string.h>
+
+uint8_t sparklineLevel(uint16_t mgdl) {
+  if (mgdl <= SPARKLINE_MIN_MGDL) {
+    return 1;
+  }
+  if (mgdl >= SPARKLINE_MAX_MGDL) {
+    return SPARKLINE_TOP;
+  }
+  uint32_t above = mgdl - SPARKLINE_MIN_MGDL;
+  return (uint8_t)(1 + above * (SPARKLINE_TOP - 1) / (SPARKLINE_MAX_MGDL - SPARKLINE_MIN_MGDL));
+}
+
+void sparklineFrom(const GlucoseHistory& history, Sparkline& out) {
+  memset(out.level, SPARKLINE_GAP, sizeof(out.level));
+  if (history.size() == 0) {
+    return;
+  }
+  uint32_t newest = history.latest().timestamp;
+  // newest first, so the walk stops at the first reading left of the line
+  for (size_t i = history.size(); i-- > 0;) {
+    HistoryEntry entry = history.at(i);
+    uint32_t slot = (newest - entry.timestamp + SPARKLINE_SLOT_S / 2) / SPARKLINE_SLOT_S;
+    if (slot >= SPARKLINE_POINTS) {
+      break;
+    }
+    uint8_t& level = out.level[SPARKLINE_POINTS - 1 - slot];
+    if (level == SPARKLINE_GAP) { // a jittered pair of readings keeps the newer one
+      level = sparklineLevel(entry.mgdl);
+    }
+  }
+}
+
+DisplayView displayView(uint16_t mgdl, Trend trend, bool stale) {
+  DisplayView view;
+  view.frame = glucoseFrame(mgdl, trend);
+  view.mgdl = mgdl;
+  view.trend = trend;
+  view.stale = stale;
+  memset(view.spark.level, SPARKLINE_GAP, sizeof(view.spark.level));
+  return view;
+}
+
+uint8_t displayDirty(const DisplayView& shown, const DisplayView& next) {
+  uint8_t dirty = 0;
+  if (shown.mgdl != next.mgdl || memcmp(shown.frame.seg, next.frame.seg, sizeof(next.frame.seg)) != 0) {
+    dirty |= DISPLAY_REGION_VALUE;
+  }
+  if (shown.trend != next.trend) {
+    dirty |= DISPLAY_REGION_TREND;
+  }
+  if (shown.stale != next.stale) {
+    dirty |= DISPLAY_REGION_STALE;
+  }
+  if (memcmp(shown.spark.level, next.spark.level, sizeof(next.spark.level)) != 0) {
+    dirty |= DISPLAY_REGION_SPARKLINE;
+  }
+  return dirty;
+}
+
+size_t glucoseText(char* out, size_t size, uint16_t mgdl) {
+  int len;
+  if (mgdl == GLUCOSE_NONE) {
+    len = snprintf(out, size, "---");
+  } else if (CONFIG.unit == GlucoseUnit::MmolL) {
+    uint16_t tenths = mgdlToTenths(mgdl);
+    len = snprintf(out, size, "%u.%u", (unsigned)(tenths / 10), (unsigned)(tenths % 10));
+  } else {
+    len = snprintf(out, size, "%u", (unsigned)mgdl);
+  }
+  return len < 0 ? 0 : (size_t)len;
+}
@@ -0,0 +1,69 @@
+// lib/glucose_core/src/display_view.h - what a display shows, for any display backend
+#ifndef DISPLAY_VIEW_H
+#define DISPLAY_VIEW_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "glucose_frame.h"
+#include "glucose_history.h"
+#include "glucose_reading.h"
+
+// Sparkline of the pixel displays: one point per CGM slot, ending at the
+// newest reading, on a fixed scale so the threshold lines stay put
+#ifndef SPARKLINE_POINTS
+#define SPARKLINE_POINTS 48 // 4 h at 5-minute cadence
+#endif
+#ifndef SPARKLINE_SLOT_S
+#define SPARKLINE_SLOT_S 300
+#endif
+#ifndef SPARKLINE_MIN_MGDL
+#define SPARKLINE_MIN_MGDL 40
+#endif
+#ifndef SPARKLINE_MAX_MGDL
+#define SPARKLINE_MAX_MGDL 300
+#endif
+static_assert(SPARKLINE_POINTS > 1 && SPARKLINE_POINTS <= 255, "SPARKLINE_POINTS must be 2..255");
+static_assert(SPARKLINE_MIN_MGDL < SPARKLINE_MAX_MGDL, "SPARKLINE_MIN_MGDL must be below SPARKLINE_MAX_MGDL");
+
+const uint8_t SPARKLINE_GAP = 0;   // no reading in that slot
+const uint8_t SPARKLINE_TOP = 255; // SPARKLINE_MAX_MGDL and above
+
+struct Sparkline {
+  uint8_t level[SPARKLINE_POINTS]; // oldest first, 1..SPARKLINE_TOP or SPARKLINE_GAP
+};
+
+// Level of a reading on the sparkline scale (1 = SPARKLINE_MIN_MGDL and
+// below), e.g. for the lines of CONFIG.lowMgdl and CONFIG.highMgdl
+uint8_t sparklineLevel(uint16_t mgdl);
+// The newest SPARKLINE_POINTS slots of history; all gaps if it is empty
+void sparklineFrom(const GlucoseHistory& history, Sparkline& out);
+
+// One user's reading as the display task gets it: segment displays draw
+// the frame, pixel displays the fields after it
+struct DisplayView {
+  DisplayFrame frame; // glucoseFrame(mgdl, trend)
+  uint16_t mgdl;      // GLUCOSE_NONE before the first reading
+  Trend trend;
+  bool stale;         // restored after a reset, no reading since
+  Sparkline spark;    // all gaps unless the backend draws one
+};
+
+// Frame computed, sparkline empty
+DisplayView displayView(uint16_t mgdl, Trend trend, bool stale);
+
+// Parts of a view a backend can redraw on their own (the partial refresh
+// of e-paper)
+const uint8_t DISPLAY_REGION_VALUE = 1 << 0; // number, or the frame
+const uint8_t DISPLAY_REGION_TREND = 1 << 1;
+const uint8_t DISPLAY_REGION_STALE = 1 << 2;
+const uint8_t DISPLAY_REGION_SPARKLINE = 1 << 3;
+const uint8_t DISPLAY_REGION_ALL = 0x0f;
+
+// Regions that differ between the shown view and the next one
+uint8_t displayDirty(const DisplayView& shown, const DisplayView& next);
+
+// Reading as text in CONFIG.unit ("5.4", "12.0", "97"), "---" for
+// GLUCOSE_NONE; returns the length, cut to fit size like snprintf
+size_t glucoseText(char* out, size_t size, uint16_t mgdl);
+
+#endif // DISPLAY_VIEW_H
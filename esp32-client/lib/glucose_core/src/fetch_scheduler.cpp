@@ -0,0 +1,62 @@
+#include "fetch_scheduler.h"
+
+static uint32_t clampDelay(uint32_t ms, uint32_t maxMs) {
+  return ms < FetchScheduler::MIN_DELAY_MS ? FetchScheduler::MIN_DELAY_MS
+         : ms > maxMs ? maxMs : ms;
+}
+
+uint32_t FetchScheduler::onReading(uint32_t timestamp, uint32_t publishedAt, uint32_t now) {
+  if (timestamp == 0 || timestamp <= _lastTimestamp) {
+    return onUnchanged();
+  }
+  _errors = 0;
+  _unchanged = 0;
+
+  if (_lastTimestamp != 0) {
+    // a gap of about one period refines the estimate; skipped readings
+    // (two or more periods) and clock jumps are ignored
+    uint32_t delta = timestamp - _lastTimestamp;
+    if (delta >= _periodS / 2 && delta <= _periodS + _periodS / 2) {
+      _periodS = (3 * _periodS + delta + 2) / 4;
+    }
+  }
+  _lastTimestamp = timestamp;
+
+  if (publishedAt >= timestamp && publishedAt - timestamp < 2 * _periodS) {
+    // follow a shorter latency at once, a longer one only gradually: a
+    // late poll sees a later fetched_at than the first publication
+    uint32_t latency = publishedAt - timestamp;
+    bool first = _latencyS == 0;
+    _latencyS = first || latency < _latencyS ? latency : (3 * _latencyS + latency + 2) / 4;
+  }
+
+  uint32_t maxMs = 2 * _periodS * 1000;
+  uint32_t next = timestamp + _periodS + _latencyS + FETCH_MARGIN_S;
+  if (now == 0) {
+    // no clock: assume the reading was just published
+    return clampDelay((_periodS + FETCH_MARGIN_S) * 1000, maxMs);
+  }
+  return next > now ? clampDelay((next - now) * 1000, maxMs) : MIN_DELAY_MS;
+}
+
+uint32_t FetchScheduler::onUnchanged() {
+  _errors = 0;
+  uint32_t ms = UNCHANGED_RETRY_MS << (_unchanged < 8 ? _unchanged : 8);
+  if (_unchanged < 255) {
+    _unchanged++;
+  }
+  return clampDelay(ms, _fallbackMs);
+}
+
+uint32_t FetchScheduler::onError(uint32_t random) {
+  uint32_t window = ERROR_BACKOFF_MS << (_errors < 6 ? _errors : 6);
+  if (window > MAX_BACKOFF_MS) {
+    window = MAX_BACKOFF_MS;
+  }
+  if (_errors < 255) {
+    _errors++;
+  }
+  // "equal jitter": half the window plus a random part of the other half,
+  // so devices that lost the backend together don't retry in lockstep
+  return window / 2 + random % (window / 2 + 1);
+}
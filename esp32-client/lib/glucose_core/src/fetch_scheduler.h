@@ -0,0 +1,61 @@
+// lib/glucose_core/src/fetch_scheduler.h - fetch timing aligned to the CGM cadence
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#include <stdint.h>
+
+// Nominal sensor cadence; the scheduler refines it from main.timestamp
+#ifndef FETCH_CGM_PERIOD_S
+#define FETCH_CGM_PERIOD_S 300
+#endif
+// Fetch this long after a reading is expected to have been published
+#ifndef FETCH_MARGIN_S
+#define FETCH_MARGIN_S 10
+#endif
+
+// Decides how long to wait before the next poll of latest.json. Each
+// on*() call reports the outcome of a fetch and returns that delay (ms).
+//
+// A new reading appears at timestamp + period + latency, where period is
+// the sensor cadence (learned from consecutive main.timestamp values) and
+// latency the delay until the ingestor publishes it (fetched_at_unix_ms -
+// main.timestamp). The next fetch is placed just after that point instead
+// of polling at a fixed rate. A fetch that finds no new reading retries
+// with growing gaps of at most fallbackMs; errors back off exponentially
+// with jitter, so a broken backend isn't hit on every loop.
+//
+// The state holds no millis() values and the constructor is constexpr,
+// so an RTC_DATA_ATTR instance keeps what it learned across deep sleep.
+class FetchScheduler {
+public:
+  static const uint32_t MIN_DELAY_MS = 5000;
+  static const uint32_t UNCHANGED_RETRY_MS = 15000; // doubles per retry
+  static const uint32_t ERROR_BACKOFF_MS = 5000;    // doubles per error
+  static const uint32_t MAX_BACKOFF_MS = 300000;
+
+  constexpr explicit FetchScheduler(uint32_t fallbackMs)
+    : _fallbackMs(fallbackMs), _lastTimestamp(0), _periodS(FETCH_CGM_PERIOD_S),
+      _latencyS(0), _unchanged(0), _errors(0) {}
+
+  // Fetched a reading with sensor time timestamp. publishedAt = when the
+  // ingestor wrote it, now = current time (unix s, 0 if unknown).
+  // A timestamp that is not newer than the last one counts as unchanged.
+  uint32_t onReading(uint32_t timestamp, uint32_t publishedAt, uint32_t now);
+  // Fetched, but nothing new (304 / same ETag / same timestamp)
+  uint32_t onUnchanged();
+  // Network or HTTP error; random is any uniformly distributed value
+  uint32_t onError(uint32_t random);
+
+  uint32_t periodS() const { return _periodS; }
+  uint32_t latencyS() const { return _latencyS; }
+
+private:
+  uint32_t _fallbackMs;
+  uint32_t _lastTimestamp;
+  uint32_t _periodS;
+  uint32_t _latencyS;
+  uint8_t _unchanged;
+  uint8_t _errors;
+};
+
+#endif // FETCH_SCHEDULER_H
@@ -0,0 +1,9 @@
+#include "fnv1a.h"
+
+uint32_t fnv1a(const char* text) {
+  uint32_t h = 2166136261u;
+  while (*text) {
+    h = (h ^ (uint8_t)*text++) * 16777619u;
+  }
+  return h;
+}
@@ -0,0 +1,11 @@
+// lib/glucose_core/src/fnv1a.h - 32-bit FNV-1a hash of a string
+#ifndef FNV1A_H
+#define FNV1A_H
+
+#include <stdint.h>
+
+// Short ids of names kept in RTC memory and NVS (user ids, SSIDs); not
+// collision-proof, but a mismatch only costs a cold start
+uint32_t fnv1a(const char* text);
+
+#endif // FNV1A_H
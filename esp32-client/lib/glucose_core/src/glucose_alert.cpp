@@ -0,0 +1,24 @@
+#include "glucose_alert.h"
+
+AlertStatus evaluateAlert(const GlucoseHistory& history, uint32_t now) {
+  AlertStatus status{ false, false, false, 0 };
+  if (history.size() == 0) {
+    return status;
+  }
+  uint32_t latest = history.latest().timestamp;
+  if (now == 0 || now < latest) {
+    now = latest; // unsynced clock (or reading from the future): no age
+  }
+  uint32_t age = now - latest;
+  status.stale = age > ALERT_STALE_AFTER_S;
+
+  // the trend line also keeps running while no new readings arrive, so a
+  // falling trend still raises the alarm when the network is down
+  if (history.trend() == Trend::Unknown || age > ALERT_PREDICT_MAX_AGE_S) {
+    return status;
+  }
+  status.predicted = true;
+  status.predictedMgdl = history.predict(now + ALERT_HORIZON_MIN * 60);
+  status.predictedLow = status.predictedMgdl < CONFIG.lowMgdl;
+  return status;
+}
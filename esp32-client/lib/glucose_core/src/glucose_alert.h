@@ -0,0 +1,36 @@
+// lib/glucose_core/src/glucose_alert.h - on-device low prediction and stale-data check
+#ifndef GLUCOSE_ALERT_H
+#define GLUCOSE_ALERT_H
+
+#include <stdint.h>
+#include "glucose_config.h"
+#include "glucose_history.h"
+
+// How far ahead the trend line is extrapolated towards CONFIG.lowMgdl;
+// override e.g. with build_flags = -DALERT_HORIZON_MIN=30
+#ifndef ALERT_HORIZON_MIN
+#define ALERT_HORIZON_MIN 20
+#endif
+// Newest reading older than this (s) counts as stale; the CGM publishes
+// every 5 minutes, so this allows for two missed readings
+#ifndef ALERT_STALE_AFTER_S
+#define ALERT_STALE_AFTER_S (15 * 60)
+#endif
+// No prediction from a trend window whose newest reading is older than
+// this (s); extrapolating further than that is guesswork
+#ifndef ALERT_PREDICT_MAX_AGE_S
+#define ALERT_PREDICT_MAX_AGE_S (30 * 60)
+#endif
+
+struct AlertStatus {
+  bool stale;         // newest reading older than ALERT_STALE_AFTER_S
+  bool predicted;     // predictedMgdl is valid
+  bool predictedLow;  // trend line crosses CONFIG.lowMgdl within the horizon
+  int32_t predictedMgdl; // value at now + horizon
+};
+
+// Evaluates the history against the current unix time. now = 0 means the
+// clock is not synced yet: no stale check, prediction from latest().
+AlertStatus evaluateAlert(const GlucoseHistory& history, uint32_t now);
+
+#endif // GLUCOSE_ALERT_H
@@ -0,0 +1,99 @@
+// lib/glucose_core/src/glucose_config.h - compile-time configuration of a board variant
+#ifndef GLUCOSE_CONFIG_H
+#define GLUCOSE_CONFIG_H
+
+#include <stdint.h>
+
+enum class GlucoseUnit : uint8_t {
+  MmolL, // shown as a clock: 5.4 -> 5:40
+  MgdL,  // shown as a number: 97
+};
+
+enum class DisplayMode : uint8_t {
+  Value,      // reading only
+  ValueTrend, // trend arrow in the first digit when it is blank
+};
+
+// Per-variant settings, set from the env's build_flags in platformio.ini:
+//   -DGLUCOSE_UNIT=GlucoseUnit::MgdL -DGLUCOSE_HIGH_MGDL=250
+// Thresholds are in mg/dL for either unit; 70/180 match the classic
+// 3.9/10.0 mmol/L for readings with one decimal.
+#ifndef GLUCOSE_UNIT
+#define GLUCOSE_UNIT GlucoseUnit::MmolL
+#endif
+#ifndef GLUCOSE_DISPLAY_MODE
+#define GLUCOSE_DISPLAY_MODE DisplayMode::ValueTrend
+#endif
+#ifndef GLUCOSE_LOW_MGDL
+#define GLUCOSE_LOW_MGDL 70
+#endif
+#ifndef GLUCOSE_HIGH_MGDL
+#define GLUCOSE_HIGH_MGDL 180
+#endif
+// Urgent low (3.0 mmol/L): the red LED blinks fast
+#ifndef GLUCOSE_URGENT_LOW_MGDL
+#define GLUCOSE_URGENT_LOW_MGDL 54
+#endif
+#ifndef GLUCOSE_FETCH_INTERVAL_S
+#define GLUCOSE_FETCH_INTERVAL_S 60
+#endif
+#ifndef GLUCOSE_BLINK_MS
+#define GLUCOSE_BLINK_MS 500
+#endif
+// Time each person's value stays on the display when several are watched
+#ifndef GLUCOSE_CYCLE_S
+#define GLUCOSE_CYCLE_S 5
+#endif
+// LEDs dim to GLUCOSE_NIGHT_BRIGHTNESS percent from GLUCOSE_NIGHT_FROM_H
+// to GLUCOSE_NIGHT_TO_H local time (see GLUCOSE_TZ in src/main.cpp);
+// equal hours turn dimming off
+#ifndef GLUCOSE_NIGHT_FROM_H
+#define GLUCOSE_NIGHT_FROM_H 22
+#endif
+#ifndef GLUCOSE_NIGHT_TO_H
+#define GLUCOSE_NIGHT_TO_H 7
+#endif
+#ifndef GLUCOSE_NIGHT_BRIGHTNESS
+#define GLUCOSE_NIGHT_BRIGHTNESS 20
+#endif
+
+struct GlucoseConfig {
+  GlucoseUnit unit;
+  DisplayMode display;
+  uint16_t lowMgdl;  // red below
+  uint16_t highMgdl; // yellow above
+  uint16_t urgentLowMgdl; // fast red blink below
+  uint32_t fetchIntervalMs; // polling / wake-up period
+  uint16_t blinkMs;         // half period of the alert blink
+  uint16_t cycleMs;         // per-user display time with several users
+  uint8_t nightFromH;       // LED dimming from this local hour...
+  uint8_t nightToH;         // ...to this one
+  uint8_t nightBrightness;  // LED brightness at night, percent
+};
+
+// Everything reading CONFIG is resolved by the compiler: the values fold
+// into constants and unit/display select template specializations, so a
+// variant carries no code or branches for the settings it doesn't use.
+constexpr GlucoseConfig CONFIG = {
+  GLUCOSE_UNIT,
+  GLUCOSE_DISPLAY_MODE,
+  GLUCOSE_LOW_MGDL,
+  GLUCOSE_HIGH_MGDL,
+  GLUCOSE_URGENT_LOW_MGDL,
+  GLUCOSE_FETCH_INTERVAL_S * 1000UL,
+  GLUCOSE_BLINK_MS,
+  GLUCOSE_CYCLE_S * 1000U,
+  GLUCOSE_NIGHT_FROM_H,
+  GLUCOSE_NIGHT_TO_H,
+  GLUCOSE_NIGHT_BRIGHTNESS,
+};
+
+static_assert(CONFIG.lowMgdl < CONFIG.highMgdl, "GLUCOSE_LOW_MGDL must be below GLUCOSE_HIGH_MGDL");
+static_assert(CONFIG.urgentLowMgdl < CONFIG.lowMgdl, "GLUCOSE_URGENT_LOW_MGDL must be below GLUCOSE_LOW_MGDL");
+static_assert(CONFIG.fetchIntervalMs >= 10000UL, "GLUCOSE_FETCH_INTERVAL_S below 10 s would hammer RTDB");
+static_assert(CONFIG.blinkMs > 0, "GLUCOSE_BLINK_MS must be positive");
+static_assert(CONFIG.cycleMs > 0, "GLUCOSE_CYCLE_S must be positive");
+static_assert(CONFIG.nightFromH < 24 && CONFIG.nightToH < 24, "GLUCOSE_NIGHT_FROM_H/TO_H are hours 0-23");
+static_assert(CONFIG.nightBrightness > 0 && CONFIG.nightBrightness <= 100, "GLUCOSE_NIGHT_BRIGHTNESS is 1-100 %");
+
+#endif // GLUCOSE_CONFIG_H
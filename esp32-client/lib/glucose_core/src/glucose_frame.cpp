@@ -0,0 +1,59 @@
+#include "glucose_frame.h"
+
+const uint8_t DIGIT_SEGMENTS[10] = {
+  0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f,
+};
+
+DisplayFrame numberFrame(uint16_t num, uint8_t dots, bool leadingZero) {
+  DisplayFrame frame;
+  for (int i = 3; i >= 0; --i) {
+    bool blank = !leadingZero && num == 0 && i < 3;
+    frame.seg[i] = blank ? 0 : DIGIT_SEGMENTS[num % 10];
+    num /= 10;
+  }
+  for (int i = 0; i < 4; ++i) {
+    frame.seg[i] |= dots & 0x80;
+    dots <<= 1;
+  }
+  return frame;
+}
+
+typedef UnitFormat<CONFIG.unit> DisplayUnit;
+
+DisplayFrame glucoseFrame(uint16_t mgdl) {
+  if (mgdl == GLUCOSE_NONE) {
+    // show 0:00 (or 0) for invalid values
+    return numberFrame(0, DisplayUnit::DOTS, false);
+  }
+  uint32_t value = DisplayUnit::digits(mgdl);
+  if (value > 9999) {
+    // cannot display more than 4 digits; show 9999 as overflow
+    return numberFrame(9999, 0, true);
+  }
+  return numberFrame(value, DisplayUnit::DOTS, false);
+}
+
+DisplayFrame userLabelFrame(uint8_t number) {
+  DisplayFrame frame = numberFrame(number, 0, false);
+  frame.seg[0] = FRAME_SEG_B | FRAME_SEG_C | FRAME_SEG_D | FRAME_SEG_E | FRAME_SEG_F; // U
+  return frame;
+}
+
+uint8_t trendSegments(Trend trend) {
+  switch (trend) {
+    case Trend::RisingFast: return FRAME_SEG_A | FRAME_SEG_B | FRAME_SEG_F;
+    case Trend::Rising: return FRAME_SEG_A;
+    case Trend::Flat: return FRAME_SEG_G;
+    case Trend::Falling: return FRAME_SEG_D;
+    case Trend::FallingFast: return FRAME_SEG_D | FRAME_SEG_C | FRAME_SEG_E;
+    default: return 0;
+  }
+}
+
+DisplayFrame glucoseFrame(uint16_t mgdl, Trend trend) {
+  DisplayFrame frame = glucoseFrame(mgdl);
+  if (mgdl != GLUCOSE_NONE) {
+    TrendFormat<CONFIG.display>::apply(frame, trend);
+  }
+  return frame;
+}
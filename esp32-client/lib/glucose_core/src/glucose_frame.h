@@ -0,0 +1,74 @@
+// lib/glucose_core/src/glucose_frame.h - reading to TM1637 segment frame
+#ifndef GLUCOSE_FRAME_H
+#define GLUCOSE_FRAME_H
+
+#include <stdint.h>
+#include "glucose_config.h"
+#include "glucose_history.h"
+#include "glucose_reading.h"
+
+// Segment bits as in TM1637Display.h (defined here so the frame code
+// builds without the display library)
+const uint8_t FRAME_SEG_A = 0b00000001;
+const uint8_t FRAME_SEG_B = 0b00000010;
+const uint8_t FRAME_SEG_C = 0b00000100;
+const uint8_t FRAME_SEG_D = 0b00001000;
+const uint8_t FRAME_SEG_E = 0b00010000;
+const uint8_t FRAME_SEG_F = 0b00100000;
+const uint8_t FRAME_SEG_G = 0b01000000;
+const uint8_t FRAME_COLON = 0b01000000; // dots argument: colon after digit 1
+
+// 4-digit TM1637 frame, computed once per reading
+struct DisplayFrame {
+  uint8_t seg[4];
+};
+
+// Segments of 0-9, same bits as TM1637Display::encodeDigit() but without
+// the call (and its bounds mask) per digit
+extern const uint8_t DIGIT_SEGMENTS[10];
+
+// Same digit layout as showNumberDecEx(): right-aligned, blank leading
+// zeros unless leadingZero, dots (0b01000000 = colon) on digit 2
+DisplayFrame numberFrame(uint16_t num, uint8_t dots, bool leadingZero);
+
+// Integer display digits for a mg/dL reading, per unit
+template <GlucoseUnit U> struct UnitFormat;
+
+// mmol/L as clock H:MM with the colon as decimal separator
+// - example: 3 -> 3:00, 3.5 -> 3:50 (readings carry one decimal)
+template <> struct UnitFormat<GlucoseUnit::MmolL> {
+  static const uint8_t DOTS = FRAME_COLON;
+  static uint32_t digits(uint16_t mgdl) { return (uint32_t)mgdlToTenths(mgdl) * 10; }
+};
+
+template <> struct UnitFormat<GlucoseUnit::MgdL> {
+  static const uint8_t DOTS = 0;
+  static uint32_t digits(uint16_t mgdl) { return mgdl; }
+};
+
+// Trend arrow drawn into the first digit, which is blank below 10 mmol/L:
+// top/bottom bar = rising/falling, plus the sides when fast, dash = flat
+uint8_t trendSegments(Trend trend);
+
+template <DisplayMode M> struct TrendFormat {
+  static void apply(DisplayFrame&, Trend) {}
+};
+
+template <> struct TrendFormat<DisplayMode::ValueTrend> {
+  static void apply(DisplayFrame& frame, Trend trend) {
+    if (frame.seg[0] == 0) {
+      frame.seg[0] = trendSegments(trend);
+    }
+  }
+};
+
+// Reading on the 4-digit display in CONFIG.unit (0:00 / 0 for
+// GLUCOSE_NONE, 9999 on overflow), with the trend per CONFIG.display
+DisplayFrame glucoseFrame(uint16_t mgdl);
+DisplayFrame glucoseFrame(uint16_t mgdl, Trend trend);
+
+// "U  n" shown before the value of the n-th (1-based) user when the
+// display cycles between several people
+DisplayFrame userLabelFrame(uint8_t number);
+
+#endif // GLUCOSE_FRAME_H
@@ -0,0 +1,109 @@
+#include "glucose_history.h"
+
+GlucoseHistory::GlucoseHistory() {
+  clear();
+}
+
+void GlucoseHistory::clear() {
+  _head = 0;
+  _count = 0;
+  _base = 0;
+  _windowCount = 0;
+  _sumX = _sumY = _sumXX = _sumXY = 0;
+}
+
+HistoryEntry GlucoseHistory::at(size_t i) const {
+  size_t slot = index(i);
+  return HistoryEntry{ _timestamps[slot], _mgdl[slot] };
+}
+
+void GlucoseHistory::accumulate(size_t slot, int sign) {
+  int64_t x = (int64_t)_timestamps[slot] - (int64_t)_base;
+  int64_t y = _mgdl[slot];
+  _sumX += sign * x;
+  _sumY += sign * y;
+  _sumXX += sign * x * x;
+  _sumXY += sign * x * y;
+}
+
+bool GlucoseHistory::add(uint32_t timestamp, uint16_t mgdl) {
+  if (_count > 0 && timestamp <= _timestamps[index(_count - 1)]) {
+    return false;
+  }
+  if (_count == 0) {
+    _base = timestamp;
+  }
+
+  if (_windowCount == TREND_WINDOW) {
+    // drop the oldest window entry; TREND_WINDOW < CAPACITY, so it is
+    // still in the ring even if the write below overwrites the oldest slot
+    accumulate(index(_count - TREND_WINDOW), -1);
+    _windowCount--;
+  }
+
+  _timestamps[_head] = timestamp;
+  _mgdl[_head] = mgdl;
+  accumulate(_head, +1);
+  _windowCount++;
+
+  _head = (_head + 1) % CAPACITY;
+  if (_count < CAPACITY) {
+    _count++;
+  }
+  return true;
+}
+
+float GlucoseHistory::slope() const {
+  if (_windowCount < 2) {
+    return 0.0f;
+  }
+  int64_t n = (int64_t)_windowCount;
+  int64_t den = n * _sumXX - _sumX * _sumX;
+  if (den == 0) {
+    return 0.0f;
+  }
+  int64_t num = n * _sumXY - _sumX * _sumY;
+  return (float)num / (float)den * 60.0f; // per second -> per minute
+}
+
+// Rounded integer division for a positive divisor
+static int64_t divRound(int64_t num, int64_t den) {
+  return (num >= 0 ? num + den / 2 : num - den / 2) / den;
+}
+
+int32_t GlucoseHistory::predict(uint32_t timestamp) const {
+  if (_windowCount < 2) {
+    return _count > 0 ? (int32_t)latest().mgdl : 0;
+  }
+  int64_t n = (int64_t)_windowCount;
+  int64_t den = n * _sumXX - _sumX * _sumX;
+  if (den == 0) {
+    return (int32_t)divRound(_sumY, n);
+  }
+  // y(x) = mean(y) + b * (x - mean(x)) with b = num / den, i.e.
+  // (sumY * den + num * (n * x - sumX)) / (n * den)
+  int64_t num = n * _sumXY - _sumX * _sumY;
+  int64_t dx = n * ((int64_t)timestamp - (int64_t)_base) - _sumX;
+  return (int32_t)divRound(_sumY * den + num * dx, n * den);
+}
+
+// Thresholds follow the usual CGM arrow convention (mg/dL per minute). The
+// slope num / den * 60 is compared by cross-multiplying (den >= 0).
+Trend GlucoseHistory::trend() const {
+  if (_windowCount < 2) {
+    return Trend::Unknown;
+  }
+  int64_t n = (int64_t)_windowCount;
+  int64_t den = n * _sumXX - _sumX * _sumX;
+  int64_t perMinute = (n * _sumXY - _sumX * _sumY) * 60;
+  if (perMinute <= -2 * den) {
+    return Trend::FallingFast;
+  } else if (perMinute <= -den) {
+    return Trend::Falling;
+  } else if (perMinute < den) {
+    return Trend::Flat;
+  } else if (perMinute < 2 * den) {
+    return Trend::Rising;
+  }
+  return Trend::RisingFast;
+}
@@ -0,0 +1,63 @@
+// lib/glucose_core/src/glucose_history.h - on-device reading history and trend
+#ifndef GLUCOSE_HISTORY_H
+#define GLUCOSE_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct HistoryEntry {
+  uint32_t timestamp; // unix s
+  uint16_t mgdl;
+};
+
+enum class Trend : uint8_t { Unknown, FallingFast, Falling, Flat, Rising, RisingFast };
+
+// Fixed-capacity ring of readings, stored as two parallel arrays (6 bytes
+// per entry, no padding). The least-squares slope over the newest
+// TREND_WINDOW entries is maintained with running sums, so add() and
+// slope()/trend() are O(1) and never rescan the buffer.
+class GlucoseHistory {
+public:
+  static const size_t CAPACITY = 288;   // 24 h at 5-minute cadence
+  static const size_t TREND_WINDOW = 4; // ~15 min of readings
+
+  GlucoseHistory();
+
+  // Appends a reading; readings not newer than the latest one are ignored
+  // (returns false), so repeated polls of the same value are harmless.
+  bool add(uint32_t timestamp, uint16_t mgdl);
+  void clear();
+
+  size_t size() const { return _count; }
+  // i = 0 is the oldest entry
+  HistoryEntry at(size_t i) const;
+  HistoryEntry latest() const { return at(_count - 1); }
+
+  // mg/dL per minute over the trend window; 0 with fewer than 2 entries
+  // (float, for logging only - trend() and predict() are integer)
+  float slope() const;
+  Trend trend() const;
+  // mg/dL on the trend window's regression line at the given time, i.e.
+  // a linear extrapolation when timestamp is past latest(); needs 2 entries.
+  // Can be negative for a steep fall.
+  int32_t predict(uint32_t timestamp) const;
+
+private:
+  size_t index(size_t i) const { return (_head + CAPACITY - _count + i) % CAPACITY; }
+  void accumulate(size_t slot, int sign);
+
+  uint32_t _timestamps[CAPACITY];
+  uint16_t _mgdl[CAPACITY];
+  size_t _head;  // next slot to write
+  size_t _count;
+
+  // sums over the window, x = seconds since _base (exact in 64-bit)
+  uint32_t _base;
+  size_t _windowCount;
+  int64_t _sumX;
+  int64_t _sumY;
+  int64_t _sumXX;
+  int64_t _sumXY;
+};
+
+#endif // GLUCOSE_HISTORY_H
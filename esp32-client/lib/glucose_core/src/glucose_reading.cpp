@@ -0,0 +1,35 @@
+#include "glucose_reading.h"
+
+bool parseMmol(const char* text, size_t len, uint16_t& mgdl) {
+  uint32_t centi = 0;
+  int decimals = -1; // -1 until the decimal point
+  size_t digits = 0;
+  for (size_t i = 0; i < len; ++i) {
+    char c = text[i];
+    if (c == '.' && decimals < 0) {
+      decimals = 0;
+    } else if (c >= '0' && c <= '9') {
+      if (decimals >= 2) {
+        continue;
+      }
+      if (decimals < 0 && centi > 99) {
+        return false; // 1000 mmol/L and more is not a reading (and would overflow)
+      }
+      centi = centi * 10 + (uint32_t)(c - '0');
+      digits++;
+      if (decimals >= 0) {
+        decimals++;
+      }
+    } else {
+      return false;
+    }
+  }
+  if (digits == 0) {
+    return false;
+  }
+  for (int i = decimals < 0 ? 0 : decimals; i < 2; ++i) {
+    centi *= 10;
+  }
+  mgdl = centiMmolToMgdl(centi);
+  return true;
+}
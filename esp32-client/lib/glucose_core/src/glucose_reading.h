@@ -0,0 +1,41 @@
+// lib/glucose_core/src/glucose_reading.h - one reading as received from RTDB
+#ifndef GLUCOSE_READING_H
+#define GLUCOSE_READING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Readings travel through the firmware as integer mg/dL (the S2 has no
+// FPU, so every float operation is a soft-float call). mg/dL is finer than
+// the ingestor's 0.1 mmol/L, so mmol/L tenths convert back exactly.
+const uint16_t GLUCOSE_NONE = 0; // no reading (yet)
+
+struct GlucoseReading {
+  uint16_t mgdl;      // GLUCOSE_NONE if unknown
+  uint32_t timestamp; // sensor time (main.timestamp, unix s), 0 if unknown
+};
+
+// 1 mmol/L = 18.016 mg/dL, rounded to the nearest integer
+inline uint16_t centiMmolToMgdl(uint32_t centi) {
+  return (uint16_t)((centi * 18016UL + 50000UL) / 100000UL);
+}
+
+inline uint16_t tenthsToMgdl(uint32_t tenths) {
+  return centiMmolToMgdl(tenths * 10);
+}
+
+inline uint16_t mgdlToTenths(uint16_t mgdl) {
+  return (uint16_t)(((uint32_t)mgdl * 10000UL + 9008UL) / 18016UL);
+}
+
+// For values ArduinoJson has already parsed into a float
+inline uint16_t mmolToMgdl(float mmol) {
+  return mmol <= 0.0f ? GLUCOSE_NONE : (uint16_t)(mmol * 18.016f + 0.5f);
+}
+
+// Parses a decimal mmol/L number ("5.4", "12", "5.45") with integer math;
+// digits past the second decimal are ignored. False if it is not a plain
+// non-negative number.
+bool parseMmol(const char* text, size_t len, uint16_t& mgdl);
+
+#endif // GLUCOSE_READING_H
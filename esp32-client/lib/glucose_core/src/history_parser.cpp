@@ -0,0 +1,85 @@
+#include "history_parser.h"
+#include "glucose_reading.h"
+
+void HistoryParser::reset() {
+  _state = BEFORE_KEY;
+  _keyValid = false;
+  _key = 0;
+  _numberLen = 0;
+  _depth = 0;
+  _timestamp = 0;
+  _mgdl = GLUCOSE_NONE;
+}
+
+bool HistoryParser::finishValue() {
+  uint16_t mgdl = GLUCOSE_NONE;
+  // 0 mmol/L maps to GLUCOSE_NONE, which is no reading
+  bool ok = _keyValid && parseMmol(_number, _numberLen, mgdl) && mgdl != GLUCOSE_NONE;
+  if (ok) {
+    _timestamp = _key;
+    _mgdl = mgdl;
+  }
+  _state = BEFORE_KEY;
+  return ok;
+}
+
+bool HistoryParser::feed(char c) {
+  switch (_state) {
+    case BEFORE_KEY:
+      if (c == '"') {
+        _state = KEY;
+        _keyValid = true;
+        _key = 0;
+      }
+      return false;
+
+    case KEY:
+      if (c == '"') {
+        _state = BEFORE_VALUE;
+      } else if (c >= '0' && c <= '9') {
+        _key = _key * 10 + (uint32_t)(c - '0');
+      } else {
+        _keyValid = false;
+      }
+      return false;
+
+    case BEFORE_VALUE:
+      if (c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        return false;
+      }
+      if ((c >= '0' && c <= '9') || c == '-') {
+        _state = VALUE;
+        _numberLen = 0;
+        _number[_numberLen++] = c;
+      } else {
+        // null, string or object: skip up to the next top-level ','
+        _state = SKIP_VALUE;
+        _depth = (c == '{' || c == '[') ? 1 : 0;
+      }
+      return false;
+
+    case VALUE:
+      if (c == ',' || c == '}' || c == ' ' || c == '\r' || c == '\n') {
+        return finishValue();
+      }
+      if (_numberLen < sizeof(_number) - 1) {
+        _number[_numberLen++] = c;
+      }
+      return false;
+
+    case SKIP_VALUE:
+      if (c == '{' || c == '[') {
+        _depth++;
+      } else if (c == '}' || c == ']') {
+        if (_depth == 0) {
+          _state = BEFORE_KEY; // end of the outer object
+        } else {
+          _depth--;
+        }
+      } else if (c == ',' && _depth == 0) {
+        _state = BEFORE_KEY;
+      }
+      return false;
+  }
+  return false;
+}
@@ -0,0 +1,37 @@
+// lib/glucose_core/src/history_parser.h - incremental parser for the RTDB history node
+#ifndef HISTORY_PARSER_H
+#define HISTORY_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Parses {"<unix_ts>": <mmol/L>, ...} one character at a time, so the
+// response can be read straight from the socket into GlucoseHistory
+// without buffering the body or building a JSON document. Entries whose
+// key is not a number or whose value is not a plain number are skipped.
+class HistoryParser {
+public:
+  HistoryParser() { reset(); }
+  void reset();
+
+  // Returns true when c completed an entry; read it via timestamp()/mgdl()
+  bool feed(char c);
+  uint32_t timestamp() const { return _timestamp; }
+  uint16_t mgdl() const { return _mgdl; }
+
+private:
+  enum State { BEFORE_KEY, KEY, BEFORE_VALUE, VALUE, SKIP_VALUE };
+
+  bool finishValue();
+
+  State _state;
+  bool _keyValid;
+  uint32_t _key;
+  char _number[16];
+  size_t _numberLen;
+  int _depth; // nesting while skipping a non-numeric value
+  uint32_t _timestamp;
+  uint16_t _mgdl;
+};
+
+#endif // HISTORY_PARSER_H
@@ -0,0 +1,130 @@
+#include "hmac_sha256.h"
+
+#include <string.h>
+
+static const size_t BLOCK_SIZE = 64;
+
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+struct Sha256 {
+  uint32_t h[8];
+  uint8_t block[BLOCK_SIZE];
+  size_t used;   // bytes in block
+  uint64_t bits; // message length so far
+};
+
+static uint32_t rotr(uint32_t x, unsigned n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+static void compress(Sha256& s) {
+  uint32_t w[64];
+  for (size_t i = 0; i < 16; ++i) {
+    const uint8_t* p = s.block + i * 4;
+    w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+  }
+  for (size_t i = 16; i < 64; ++i) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t v[8];
+  memcpy(v, s.h, sizeof(v));
+  for (size_t i = 0; i < 64; ++i) {
+    uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+    uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+    uint32_t t1 = v[7] + (rotr(v[4], 6) ^ rotr(v[4], 11) ^ rotr(v[4], 25)) + ch + K[i] + w[i];
+    uint32_t t2 = (rotr(v[0], 2) ^ rotr(v[0], 13) ^ rotr(v[0], 22)) + maj;
+    memmove(v + 1, v, 7 * sizeof(v[0])); // a..g move down to b..h
+    v[4] += t1;
+    v[0] = t1 + t2;
+  }
+  for (size_t i = 0; i < 8; ++i) {
+    s.h[i] += v[i];
+  }
+}
+
+static void begin(Sha256& s) {
+  static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(s.h, H0, sizeof(s.h));
+  s.used = 0;
+  s.bits = 0;
+}
+
+static void update(Sha256& s, const uint8_t* data, size_t len) {
+  s.bits += (uint64_t)len * 8;
+  while (len--) {
+    s.block[s.used++] = *data++;
+    if (s.used == BLOCK_SIZE) {
+      compress(s);
+      s.used = 0;
+    }
+  }
+}
+
+static void finish(Sha256& s, uint8_t out[SHA256_SIZE]) {
+  uint64_t bits = s.bits;
+  uint8_t pad = 0x80;
+  update(s, &pad, 1);
+  pad = 0;
+  while (s.used != BLOCK_SIZE - 8) {
+    update(s, &pad, 1);
+  }
+  for (int i = 7; i >= 0; --i) {
+    s.block[s.used++] = (uint8_t)(bits >> (i * 8));
+  }
+  compress(s);
+  for (size_t i = 0; i < 8; ++i) {
+    out[i * 4] = (uint8_t)(s.h[i] >> 24);
+    out[i * 4 + 1] = (uint8_t)(s.h[i] >> 16);
+    out[i * 4 + 2] = (uint8_t)(s.h[i] >> 8);
+    out[i * 4 + 3] = (uint8_t)s.h[i];
+  }
+}
+
+void hmacSha256(const uint8_t* key, size_t keyLen, const uint8_t* data, size_t len,
+                uint8_t out[SHA256_SIZE]) {
+  uint8_t pad[BLOCK_SIZE] = {};
+  Sha256 s;
+  if (keyLen > BLOCK_SIZE) {
+    begin(s);
+    update(s, key, keyLen);
+    finish(s, pad);
+  } else {
+    memcpy(pad, key, keyLen);
+  }
+  for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+    pad[i] ^= 0x36;
+  }
+  uint8_t inner[SHA256_SIZE];
+  begin(s);
+  update(s, pad, BLOCK_SIZE);
+  update(s, data, len);
+  finish(s, inner);
+  for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+    pad[i] ^= 0x36 ^ 0x5c;
+  }
+  begin(s);
+  update(s, pad, BLOCK_SIZE);
+  update(s, inner, SHA256_SIZE);
+  finish(s, out);
+}
+
+bool macEqual(const uint8_t* a, const uint8_t* b, size_t len) {
+  uint8_t diff = 0;
+  for (size_t i = 0; i < len; ++i) {
+    diff |= a[i] ^ b[i];
+  }
+  return diff == 0;
+}
@@ -0,0 +1,18 @@
+// lib/glucose_core/src/hmac_sha256.h - HMAC-SHA256 for signing LAN packets
+#ifndef HMAC_SHA256_H
+#define HMAC_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+const size_t SHA256_SIZE = 32;
+
+// Plain C++ rather than mbedTLS, so the peer packets it signs stay
+// testable on the host; a packet is a few dozen bytes
+void hmacSha256(const uint8_t* key, size_t keyLen, const uint8_t* data, size_t len,
+                uint8_t out[SHA256_SIZE]);
+
+// Compares in time independent of where a and b differ
+bool macEqual(const uint8_t* a, const uint8_t* b, size_t len);
+
+#endif // HMAC_SHA256_H
@@ -0,0 +1,56 @@
+#include "latency_histogram.h"
+
+void LatencyHistogram::clear() {
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    _buckets[i] = 0;
+  }
+  _count = 0;
+  _sumUs = 0;
+  _minUs = UINT32_MAX;
+  _maxUs = 0;
+}
+
+uint32_t LatencyHistogram::bucketLimitUs(size_t i) {
+  return i + 1 < BUCKETS ? 1000UL << i : UINT32_MAX;
+}
+
+void LatencyHistogram::add(uint32_t us) {
+  size_t i = 0;
+  uint32_t ms = us / 1000;
+  if (ms > 0) {
+    // ms in [2^(k-1), 2^k) -> bucket k, i.e. the bit width of ms
+    i = 32 - __builtin_clz(ms);
+    if (i >= BUCKETS) {
+      i = BUCKETS - 1;
+    }
+  }
+  _buckets[i]++;
+  _count++;
+  _sumUs += us;
+  if (us < _minUs) {
+    _minUs = us;
+  }
+  if (us > _maxUs) {
+    _maxUs = us;
+  }
+}
+
+uint32_t LatencyHistogram::percentileUs(uint8_t p) const {
+  if (_count == 0) {
+    return 0;
+  }
+  // rank of the p-th percentile, 1-based, rounded up
+  uint32_t rank = (uint32_t)(((uint64_t)_count * p + 99) / 100);
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint32_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; ++i) {
+    seen += _buckets[i];
+    if (seen >= rank) {
+      uint32_t limit = bucketLimitUs(i);
+      return limit < _maxUs ? limit : _maxUs;
+    }
+  }
+  return _maxUs;
+}
@@ -0,0 +1,38 @@
+// lib/glucose_core/src/latency_histogram.h - fixed-size log2 histogram of durations
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bucket i counts durations below bucketLimitUs(i) = 1 ms << i (and at
+// least the previous limit); the last bucket is open-ended (>= 16.4 s).
+// 16 counters plus min/max/sum, no allocation, O(1) add().
+class LatencyHistogram {
+public:
+  static const size_t BUCKETS = 16;
+
+  LatencyHistogram() { clear(); }
+  void clear();
+  void add(uint32_t us);
+
+  uint32_t count() const { return _count; }
+  uint64_t sumUs() const { return _sumUs; }
+  uint32_t minUs() const { return _count ? _minUs : 0; }
+  uint32_t maxUs() const { return _maxUs; }
+  uint32_t bucket(size_t i) const { return _buckets[i]; }
+  // Upper limit of bucket i (exclusive); UINT32_MAX for the last one
+  static uint32_t bucketLimitUs(size_t i);
+  // Upper estimate of the p-th percentile (0-100): the limit of the
+  // bucket it falls into, capped at the largest value seen
+  uint32_t percentileUs(uint8_t p) const;
+
+private:
+  uint32_t _buckets[BUCKETS];
+  uint32_t _count;
+  uint64_t _sumUs;
+  uint32_t _minUs;
+  uint32_t _maxUs;
+};
+
+#endif // LATENCY_HISTOGRAM_H
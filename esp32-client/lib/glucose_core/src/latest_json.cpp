@@ -0,0 +1,35 @@
+#include "latest_json.h"
+
+void latestFilter(JsonDocument& filter) {
+  filter["main"]["glucose"] = true;
+  filter["main"]["timestamp"] = true;
+  filter["fetched_at_unix_ms"] = true;
+  filter["glucose"] = true; // top-level fallback
+}
+
+bool readGlucoseFields(JsonVariantConst glucose, JsonVariantConst timestamp, GlucoseReading& reading) {
+  if (glucose.isNull()) {
+    return false;
+  }
+  // mmol/L, already a float in the document
+  reading.mgdl = mmolToMgdl(glucose.as<float>());
+  reading.timestamp = timestamp.isNull() ? 0 : timestamp.as<uint32_t>();
+  return true;
+}
+
+uint32_t readPublishedAt(JsonVariantConst node) {
+  return (uint32_t)(node["fetched_at_unix_ms"].as<uint64_t>() / 1000);
+}
+
+LatestStatus extractLatest(JsonVariantConst doc, GlucoseReading& reading, uint32_t& publishedAt) {
+  publishedAt = readPublishedAt(doc);
+  JsonVariantConst main = doc["main"];
+  if (main.is<JsonObjectConst>()) {
+    return readGlucoseFields(main["glucose"], main["timestamp"], reading) ? LatestStatus::Main
+                                                                         : LatestStatus::NoGlucoseInMain;
+  }
+  if (readGlucoseFields(doc["glucose"], JsonVariantConst(), reading)) {
+    return LatestStatus::TopLevel;
+  }
+  return LatestStatus::NoGlucose;
+}
@@ -0,0 +1,37 @@
+// lib/glucose_core/src/latest_json.h - reading extraction from latest.json
+#ifndef LATEST_JSON_H
+#define LATEST_JSON_H
+
+#include <ArduinoJson.h>
+#include "glucose_reading.h"
+
+// latest.json fields kept by latestFilter(): main{glucose,timestamp},
+// fetched_at_unix_ms and a top-level glucose fallback
+const size_t LATEST_FILTER_CAPACITY = JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(2);
+// keys read from a Stream are copied into the document, hence the extra bytes
+const size_t LATEST_DOC_CAPACITY = JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(2) + 48;
+
+enum class LatestStatus : uint8_t {
+  Main,            // main.glucose (and main.timestamp, 0 if missing)
+  TopLevel,        // top-level glucose only, no timestamp
+  NoGlucoseInMain, // main without glucose
+  NoGlucose,       // neither main nor glucose
+};
+
+// Filter for deserializeJson(): drops everything extractLatest() ignores,
+// so the document size doesn't depend on the payload
+void latestFilter(JsonDocument& filter);
+
+// Reads the reading and publishedAt (fetched_at_unix_ms in s, 0 if
+// missing); reading is only set for Main and TopLevel
+LatestStatus extractLatest(JsonVariantConst doc, GlucoseReading& reading, uint32_t& publishedAt);
+
+// main.glucose / main.timestamp pair as used by latest.json and the
+// stream's put/patch events; false if glucose is missing
+bool readGlucoseFields(JsonVariantConst glucose, JsonVariantConst timestamp, GlucoseReading& reading);
+
+// node's fetched_at_unix_ms (the ingestor's write of latest) in s, 0 if
+// missing; node is latest.json or the data of a stream event at "/"
+uint32_t readPublishedAt(JsonVariantConst node);
+
+#endif // LATEST_JSON_H
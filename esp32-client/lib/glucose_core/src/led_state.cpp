@@ -0,0 +1,80 @@
+#include "led_state.h"
+
+LedColor ledColorFor(uint16_t mgdl) {
+  if (mgdl == GLUCOSE_NONE) {
+    return LedColor::Off;
+  }
+  if (mgdl < CONFIG.lowMgdl) {
+    return LedColor::Red;
+  } else if (mgdl > CONFIG.highMgdl) {
+    return LedColor::Yellow;
+  }
+  return LedColor::Green;
+}
+
+static int severity(LedColor color) {
+  switch (color) {
+    case LedColor::Red: return 3;
+    case LedColor::Yellow: return 2;
+    case LedColor::Green: return 1;
+    default: return 0;
+  }
+}
+
+LedState worseLedState(const LedState& a, const LedState& b) {
+  int sa = severity(a.color);
+  int sb = severity(b.color);
+  if (sa != sb) {
+    return sa > sb ? a : b;
+  }
+  if (a.blinkMs == b.blinkMs) {
+    return a.blinkMs != 0 && !a.fade ? a : b;
+  }
+  return a.blinkMs != 0 && (b.blinkMs == 0 || a.blinkMs < b.blinkMs) ? a : b;
+}
+
+LedState ledStateFor(uint16_t mgdl, const AlertStatus& alert) {
+  LedColor color = ledColorFor(mgdl);
+  if (color == LedColor::Off) {
+    return LedState{ color, 0, false };
+  }
+  // urgent whatever the data's age: the last value was already this low
+  if (mgdl < CONFIG.urgentLowMgdl) {
+    return LedState{ LedColor::Red, LED_URGENT_BLINK_MS, false };
+  }
+  if (alert.predictedLow && color != LedColor::Red) {
+    return LedState{ LedColor::Red, CONFIG.blinkMs, false };
+  }
+  if (alert.stale) {
+    return LedState{ color, LED_STALE_BLINK_MS, false };
+  }
+  if (color == LedColor::Yellow) {
+    return LedState{ color, LED_HIGH_FADE_MS, true };
+  }
+  return LedState{ color, 0, false };
+}
+
+uint8_t ledPatternLevel(const LedState& state, uint32_t ms) {
+  if (state.color == LedColor::Off) {
+    return 0;
+  }
+  if (state.blinkMs == 0) {
+    return LED_LEVEL_FULL;
+  }
+  uint32_t phase = ms % (2UL * state.blinkMs);
+  if (!state.fade) {
+    return phase < state.blinkMs ? LED_LEVEL_FULL : 0;
+  }
+  uint32_t distance = phase < state.blinkMs ? state.blinkMs - phase : phase - state.blinkMs;
+  return (uint8_t)(distance * LED_LEVEL_FULL / state.blinkMs);
+}
+
+uint8_t ledBrightnessAt(int hour) {
+  if (hour < 0 || CONFIG.nightFromH == CONFIG.nightToH) {
+    return 100;
+  }
+  bool night = CONFIG.nightFromH < CONFIG.nightToH
+                 ? hour >= CONFIG.nightFromH && hour < CONFIG.nightToH
+                 : hour >= CONFIG.nightFromH || hour < CONFIG.nightToH; // across midnight
+  return night ? CONFIG.nightBrightness : 100;
+}
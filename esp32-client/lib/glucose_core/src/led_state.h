@@ -0,0 +1,66 @@
+// lib/glucose_core/src/led_state.h - LED colour and pattern for a reading
+#ifndef LED_STATE_H
+#define LED_STATE_H
+
+#include <stdint.h>
+#include "glucose_alert.h"
+#include "glucose_reading.h"
+
+// Slow blink (half period, ms) of the current colour while data is stale
+#ifndef LED_STALE_BLINK_MS
+#define LED_STALE_BLINK_MS 2000
+#endif
+// Fast blink (half period, ms) of the red LED below CONFIG.urgentLowMgdl
+#ifndef LED_URGENT_BLINK_MS
+#define LED_URGENT_BLINK_MS 150
+#endif
+// Slow fade in and out (half period, ms) of the yellow LED when high
+#ifndef LED_HIGH_FADE_MS
+#define LED_HIGH_FADE_MS 1500
+#endif
+
+// Full level of ledPatternLevel(), before the brightness is applied
+const uint8_t LED_LEVEL_FULL = 255;
+
+enum class LedColor : uint8_t { Off, Red, Yellow, Green };
+
+// What the LED engine shows: a colour, steady, blinking or fading
+struct LedState {
+  LedColor color;
+  uint16_t blinkMs; // half period, 0 = steady
+  bool fade;        // ramp between off and full instead of switching
+  bool operator==(const LedState& o) const { return color == o.color && blinkMs == o.blinkMs && fade == o.fade; }
+  bool operator!=(const LedState& o) const { return !(*this == o); }
+};
+
+// LED state for a glucose value (thresholds from CONFIG):
+// - red if below lowMgdl (3.9 mmol/L)
+// - yellow if above highMgdl (10 mmol/L)
+// - green otherwise
+// - all off when there is no value yet
+LedColor ledColorFor(uint16_t mgdl);
+
+// The threshold colour, overridden by the local alarm (see glucose_alert.h):
+// - red blinking fast (LED_URGENT_BLINK_MS) below CONFIG.urgentLowMgdl
+// - red blinking (CONFIG.blinkMs) if the trend predicts a low within the horizon
+// - slow blinking of the current colour if the data is stale
+// - yellow slowly fading in and out (LED_HIGH_FADE_MS) when high
+LedState ledStateFor(uint16_t mgdl, const AlertStatus& alert);
+
+// The more urgent of two states, for one set of LEDs watching several
+// people: red over yellow over green over off; for the same colour, an
+// animated state wins over a steady one, the faster one over the slower,
+// and a blink over a fade
+LedState worseLedState(const LedState& a, const LedState& b);
+
+// Level of the state's LED ms into its pattern, 0..LED_LEVEL_FULL: lit
+// first, then off after blinkMs (blink) or down to off over blinkMs and
+// back up again (fade)
+uint8_t ledPatternLevel(const LedState& state, uint32_t ms);
+
+// LED brightness in percent at a local hour (0-23): CONFIG.nightBrightness
+// between CONFIG.nightFromH and CONFIG.nightToH, else 100; 100 for a
+// negative hour (clock not synced yet)
+uint8_t ledBrightnessAt(int hour);
+
+#endif // LED_STATE_H
@@ -0,0 +1,45 @@
+#include "net_supervisor.h"
+
+static const uint32_t RECONNECT_MIN_MS = NET_RECONNECT_MIN_S * 1000UL;
+static const uint32_t RECONNECT_MAX_MS = NET_RECONNECT_MAX_S * 1000UL;
+static const uint32_t RESTART_WIFI_MS = NET_RESTART_WIFI_MIN * 60000UL;
+static const uint32_t REBOOT_MS = NET_REBOOT_MIN * 60000UL;
+
+NetSupervisor::NetSupervisor(uint32_t nowMs)
+  : _successMs(nowMs), _reconnectMs(nowMs), _reconnectDelayMs(RECONNECT_MIN_MS), _restartMs(nowMs),
+    _restarts(0), _wasUp(true) {}
+
+void NetSupervisor::onSuccess(uint32_t nowMs) {
+  _successMs = nowMs;
+  _restarts = 0;
+}
+
+NetAction NetSupervisor::poll(uint32_t nowMs, bool wifiUp) {
+  if (!wifiUp && _wasUp) {
+    _reconnectMs = nowMs;
+    _reconnectDelayMs = 0; // just dropped: at once
+  }
+  _wasUp = wifiUp;
+
+  uint32_t quiet = nowMs - _successMs;
+  if (wifiUp && _restarts > 0 && quiet >= REBOOT_MS) {
+    return NetAction::Reboot;
+  }
+  if (quiet >= RESTART_WIFI_MS && (_restarts == 0 || nowMs - _restartMs >= RESTART_WIFI_MS)) {
+    _restartMs = nowMs;
+    if (_restarts < UINT8_MAX) {
+      ++_restarts;
+    }
+    _reconnectMs = nowMs;
+    _reconnectDelayMs = RECONNECT_MIN_MS;
+    return NetAction::RestartWifi;
+  }
+  if (!wifiUp && nowMs - _reconnectMs >= _reconnectDelayMs) {
+    _reconnectMs = nowMs;
+    _reconnectDelayMs = _reconnectDelayMs == 0                    ? RECONNECT_MIN_MS
+                        : _reconnectDelayMs >= RECONNECT_MAX_MS / 2 ? RECONNECT_MAX_MS
+                                                                    : 2 * _reconnectDelayMs;
+    return NetAction::Reconnect;
+  }
+  return NetAction::None;
+}
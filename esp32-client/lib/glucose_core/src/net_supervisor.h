@@ -0,0 +1,63 @@
+// lib/glucose_core/src/net_supervisor.h - escalating recovery of a stalled network path
+#ifndef NET_SUPERVISOR_H
+#define NET_SUPERVISOR_H
+
+#include <stdint.h>
+
+// Gap between reconnect attempts while the link stays down (the first
+// one goes out at once); doubles per attempt
+#ifndef NET_RECONNECT_MIN_S
+#define NET_RECONNECT_MIN_S 5
+#endif
+#ifndef NET_RECONNECT_MAX_S
+#define NET_RECONNECT_MAX_S 120
+#endif
+// No successful fetch for this long: restart the WiFi stack (and again
+// after each further period)
+#ifndef NET_RESTART_WIFI_MIN
+#define NET_RESTART_WIFI_MIN 10
+#endif
+// None for this long, the WiFi restart did not help and the link is
+// associated: reboot
+#ifndef NET_REBOOT_MIN
+#define NET_REBOOT_MIN 30
+#endif
+static_assert(NET_RECONNECT_MIN_S > 0 && NET_RECONNECT_MIN_S <= NET_RECONNECT_MAX_S,
+              "NET_RECONNECT_MIN_S must be positive and at most NET_RECONNECT_MAX_S");
+static_assert(NET_RESTART_WIFI_MIN > 0 && NET_RESTART_WIFI_MIN < NET_REBOOT_MIN,
+              "NET_RESTART_WIFI_MIN must be positive and below NET_REBOOT_MIN");
+
+enum class NetAction : uint8_t {
+  None,
+  Reconnect,   // WiFi.reconnect(), the link is down
+  RestartWifi, // WiFi off and a fresh wifiConnect()
+  Reboot,
+};
+
+// Decides, from the time since the last successful fetch and the link
+// state, what the network task should do on this pass (times are
+// millis(), wrap-safe). Reconnects while the link is down are spaced
+// with an exponential backoff instead of one per loop() pass. A reboot is
+// only chosen while WiFi is associated: then the WiFi restart did not
+// help and the stack above it (lwIP, TLS) is the suspect; with no network
+// in reach a reboot would not bring one back.
+class NetSupervisor {
+public:
+  explicit NetSupervisor(uint32_t nowMs = 0);
+
+  // A fetch, stream event or LAN reading got through
+  void onSuccess(uint32_t nowMs);
+  NetAction poll(uint32_t nowMs, bool wifiUp);
+
+  uint32_t quietMs(uint32_t nowMs) const { return nowMs - _successMs; }
+
+private:
+  uint32_t _successMs;
+  uint32_t _reconnectMs;      // last reconnect, or when the link dropped
+  uint32_t _reconnectDelayMs; // until the next one
+  uint32_t _restartMs;        // last WiFi restart
+  uint8_t _restarts;          // since the last success
+  bool _wasUp;
+};
+
+#endif // NET_SUPERVISOR_H
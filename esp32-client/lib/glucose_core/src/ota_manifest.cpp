@@ -0,0 +1,92 @@
+#include "ota_manifest.h"
+
+#include <string.h>
+
+static bool isHex(const char* s, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    char c = s[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool parseOtaManifest(JsonVariantConst doc, OtaManifest& manifest) {
+  JsonVariantConst version = doc["version"];
+  JsonVariantConst size = doc["size"];
+  const char* md5 = doc["md5"];
+  const char* url = doc["url"];
+  if (!version.is<uint32_t>() || !size.is<uint32_t>() || !md5 || !url) {
+    return false;
+  }
+  size_t md5Len = strlen(md5);
+  size_t urlLen = strlen(url);
+  if (md5Len != OTA_MD5_SIZE - 1 || !isHex(md5, md5Len) || urlLen >= OTA_URL_SIZE
+      || strncmp(url, "https://", 8) != 0) {
+    return false;
+  }
+  manifest.version = version.as<uint32_t>();
+  manifest.size = size.as<uint32_t>();
+  memcpy(manifest.md5, md5, md5Len + 1);
+  memcpy(manifest.url, url, urlLen + 1);
+  return manifest.size > 0;
+}
+
+// Header flags (FLG)
+static const uint8_t FHCRC = 0x02;
+static const uint8_t FEXTRA = 0x04;
+static const uint8_t FNAME = 0x08;
+static const uint8_t FCOMMENT = 0x10;
+static const uint8_t FRESERVED = 0xe0;
+
+// Offset just past the zero-terminated string starting at pos, 0 if it
+// doesn't end within len
+static size_t skipString(const uint8_t* data, size_t len, size_t pos) {
+  const void* end = pos < len ? memchr(data + pos, 0, len - pos) : nullptr;
+  return end ? (size_t)((const uint8_t*)end - data) + 1 : 0;
+}
+
+long gzipHeaderSize(const uint8_t* data, size_t len) {
+  // ID1 ID2 CM FLG MTIME(4) XFL OS
+  const size_t FIXED = 10;
+  if (len >= 1 && data[0] != 0x1f) {
+    return -1;
+  }
+  if (len >= 2 && data[1] != 0x8b) {
+    return -1;
+  }
+  if (len >= 3 && data[2] != 8) { // deflate
+    return -1;
+  }
+  if (len >= 4 && (data[3] & FRESERVED)) {
+    return -1;
+  }
+  if (len < FIXED) {
+    return 0;
+  }
+  uint8_t flags = data[3];
+  size_t pos = FIXED;
+  if (flags & FEXTRA) {
+    if (len < pos + 2) {
+      return 0;
+    }
+    pos += 2 + (data[pos] | (data[pos + 1] << 8)); // XLEN, little-endian
+  }
+  if (flags & FNAME) {
+    pos = skipString(data, len, pos);
+    if (pos == 0) {
+      return 0;
+    }
+  }
+  if (flags & FCOMMENT) {
+    pos = skipString(data, len, pos);
+    if (pos == 0) {
+      return 0;
+    }
+  }
+  if (flags & FHCRC) {
+    pos += 2;
+  }
+  return pos <= len ? (long)pos : 0;
+}
@@ -0,0 +1,37 @@
+// lib/glucose_core/src/ota_manifest.h - firmware manifest and gzip framing of OTA images
+#ifndef OTA_MANIFEST_H
+#define OTA_MANIFEST_H
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The manifest is a small JSON object next to the users' data, e.g.
+//   {"version": 7, "size": 1043216, "md5": "9e107d9d372bb6826bd81d3542a419d6",
+//    "url": "https://firebasestorage.googleapis.com/.../firmware-7.bin.gz?alt=media"}
+// size and md5 are of the uncompressed image, which is what ends up in
+// flash; the download may be the image itself or gzip-compressed
+// (tools/make_ota_image.py writes both the .gz and the manifest).
+const size_t OTA_URL_SIZE = 192;
+const size_t OTA_MD5_SIZE = 33; // 32 hex digits
+// strings read from a Stream are copied into the document
+const size_t OTA_MANIFEST_DOC_CAPACITY = JSON_OBJECT_SIZE(4) + OTA_URL_SIZE + OTA_MD5_SIZE + 32;
+
+struct OtaManifest {
+  uint32_t version; // compared with FIRMWARE_VERSION
+  uint32_t size;
+  char md5[OTA_MD5_SIZE];
+  char url[OTA_URL_SIZE];
+};
+
+// false if a field is missing, the url is not https or too long, or md5
+// is not 32 hex digits
+bool parseOtaManifest(JsonVariantConst doc, OtaManifest& manifest);
+
+// gzip member header (RFC 1952) in front of a raw deflate stream:
+// - its length once all of it is in data
+// - 0 if data ends inside the header
+// - -1 if data is not gzip with deflate
+long gzipHeaderSize(const uint8_t* data, size_t len);
+
+#endif // OTA_MANIFEST_H
@@ -0,0 +1,152 @@
+#include "peer_packet.h"
+
+#include <string.h>
+#include "hmac_sha256.h"
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static uint16_t get16(const uint8_t* p) {
+  return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3];
+}
+
+static void sign(const char* key, const uint8_t* buf, size_t len, uint8_t mac[SHA256_SIZE]) {
+  hmacSha256(reinterpret_cast<const uint8_t*>(key), strlen(key), buf, len, mac);
+}
+
+size_t encodePeerPacket(const PeerPacket& packet, const char* key, uint8_t* buf, size_t size) {
+  size_t len = PEER_HEADER_SIZE;
+  size_t uidLen = 0;
+  if (packet.type == PeerType::Reading) {
+    uidLen = strnlen(packet.uid, PEER_UID_SIZE);
+    if (uidLen == PEER_UID_SIZE) {
+      return 0;
+    }
+    len += 11 + uidLen;
+  }
+  if (size < len + PEER_MAC_SIZE) {
+    return 0;
+  }
+  buf[0] = 'G';
+  buf[1] = 'W';
+  buf[2] = PEER_VERSION;
+  buf[3] = (uint8_t)packet.type;
+  put32(buf + 4, packet.sender);
+  put32(buf + 8, packet.epoch);
+  put32(buf + 12, packet.seq);
+  put32(buf + 16, packet.sentAt);
+  if (packet.type == PeerType::Reading) {
+    put16(buf + 20, packet.reading.mgdl);
+    put32(buf + 22, packet.reading.timestamp);
+    put32(buf + 26, packet.publishedAt);
+    buf[30] = (uint8_t)uidLen;
+    memcpy(buf + 31, packet.uid, uidLen);
+  }
+  uint8_t mac[SHA256_SIZE];
+  sign(key, buf, len, mac);
+  memcpy(buf + len, mac, PEER_MAC_SIZE);
+  return len + PEER_MAC_SIZE;
+}
+
+bool decodePeerPacket(const uint8_t* buf, size_t len, const char* key, PeerPacket& packet) {
+  if (len < PEER_HEADER_SIZE + PEER_MAC_SIZE || buf[0] != 'G' || buf[1] != 'W' || buf[2] != PEER_VERSION) {
+    return false;
+  }
+  len -= PEER_MAC_SIZE;
+  uint8_t mac[SHA256_SIZE];
+  sign(key, buf, len, mac);
+  if (!macEqual(mac, buf + len, PEER_MAC_SIZE)) {
+    return false;
+  }
+  packet.type = (PeerType)buf[3];
+  packet.sender = get32(buf + 4);
+  packet.epoch = get32(buf + 8);
+  packet.seq = get32(buf + 12);
+  packet.sentAt = get32(buf + 16);
+  packet.uid[0] = '\0';
+  switch (packet.type) {
+    case PeerType::Hello:
+      return len == PEER_HEADER_SIZE;
+    case PeerType::Reading: {
+      if (len < PEER_HEADER_SIZE + 11) {
+        return false;
+      }
+      size_t uidLen = buf[30];
+      if (uidLen == 0 || uidLen >= PEER_UID_SIZE || len != PEER_HEADER_SIZE + 11 + uidLen) {
+        return false;
+      }
+      packet.reading.mgdl = get16(buf + 20);
+      packet.reading.timestamp = get32(buf + 22);
+      packet.publishedAt = get32(buf + 26);
+      memcpy(packet.uid, buf + 31, uidLen);
+      packet.uid[uidLen] = '\0';
+      return packet.reading.mgdl >= PEER_MIN_MGDL && packet.reading.mgdl <= PEER_MAX_MGDL;
+    }
+  }
+  return false;
+}
+
+bool PeerTable::accept(const PeerPacket& packet, uint32_t nowMs) {
+  if (packet.sender == _self) {
+    return false; // multicast loops our own packets back
+  }
+  Peer* peer = nullptr;
+  for (size_t i = 0; i < _count; ++i) {
+    if (_peers[i].id == packet.sender) {
+      peer = &_peers[i];
+      break;
+    }
+  }
+  if (peer == nullptr) {
+    if (_count < MAX_PEERS) {
+      peer = &_peers[_count++];
+    } else {
+      // full: replace the one heard least recently
+      peer = &_peers[0];
+      for (size_t i = 1; i < _count; ++i) {
+        if (nowMs - _peers[i].heardMs > nowMs - peer->heardMs) {
+          peer = &_peers[i];
+        }
+      }
+    }
+    *peer = Peer{ packet.sender, packet.epoch, packet.seq, nowMs };
+    return true;
+  }
+  if (packet.epoch == peer->epoch && (int32_t)(packet.seq - peer->seq) <= 0) {
+    return false; // duplicate or reordered
+  }
+  peer->epoch = packet.epoch;
+  peer->seq = packet.seq;
+  peer->heardMs = nowMs;
+  return true;
+}
+
+bool PeerTable::isLeader(uint32_t nowMs) const {
+  for (size_t i = 0; i < _count; ++i) {
+    if (nowMs - _peers[i].heardMs < TIMEOUT_MS && _peers[i].id < _self) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t PeerTable::alive(uint32_t nowMs) const {
+  size_t n = 0;
+  for (size_t i = 0; i < _count; ++i) {
+    n += nowMs - _peers[i].heardMs < TIMEOUT_MS ? 1 : 0;
+  }
+  return n;
+}
@@ -0,0 +1,83 @@
+// lib/glucose_core/src/peer_packet.h - LAN multicast packets shared between displays
+#ifndef PEER_PACKET_H
+#define PEER_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "glucose_reading.h"
+
+// Big-endian like the compact record:
+//   "GW", u8 version, u8 type, u32 sender, u32 epoch, u32 seq, u32 sentAt
+//   Reading adds: u16 mg/dL, u32 sensor timestamp, u32 publishedAt,
+//                 u8 uid length, uid (no terminator)
+//   then the first PEER_MAC_SIZE bytes of HMAC-SHA256 over all of the above
+// sender identifies the device (from its MAC), epoch changes on every
+// boot so the receivers know a restarted sender's seq starts over. The
+// HMAC key is shared by the displays (the LAN push token), so another
+// host on the LAN can neither post readings nor win the leader election.
+const uint8_t PEER_VERSION = 2;
+const size_t PEER_UID_SIZE = 16; // including the terminator
+const size_t PEER_HEADER_SIZE = 20;
+const size_t PEER_MAC_SIZE = 16;
+const size_t PEER_PACKET_MAX = PEER_HEADER_SIZE + 11 + PEER_UID_SIZE - 1 + PEER_MAC_SIZE;
+
+// Readings outside are taken as corrupt rather than shown (CGMs report
+// about 40..500 mg/dL)
+const uint16_t PEER_MIN_MGDL = 20;
+const uint16_t PEER_MAX_MGDL = 600;
+
+enum class PeerType : uint8_t {
+  Hello = 1,   // presence, for the leader election
+  Reading = 2, // a new reading fetched from the cloud (or pushed)
+};
+
+struct PeerPacket {
+  PeerType type;
+  uint32_t sender;
+  uint32_t epoch;
+  uint32_t seq;
+  uint32_t sentAt; // sender's unix time, 0 if unsynced
+  // Reading only
+  char uid[PEER_UID_SIZE];
+  GlucoseReading reading;
+  uint32_t publishedAt; // fetched_at of latest.json, 0 if unknown
+};
+
+// Returns the signed packet's length, 0 if buf is too small or uid too long
+size_t encodePeerPacket(const PeerPacket& packet, const char* key, uint8_t* buf, size_t size);
+// False for anything that is not a well-formed packet of this version
+// signed with key, and for readings outside PEER_MIN_MGDL..PEER_MAX_MGDL
+bool decodePeerPacket(const uint8_t* buf, size_t len, const char* key, PeerPacket& packet);
+
+// Displays heard on the LAN: drops duplicated and reordered packets per
+// sender and elects the leader, the live device with the lowest id. Only
+// the leader polls the cloud on time; the others give it a head start
+// and normally take its readings from the LAN instead.
+class PeerTable {
+public:
+  static const size_t MAX_PEERS = 8;
+  static const uint32_t TIMEOUT_MS = 30000; // three missed hellos
+
+  explicit PeerTable(uint32_t self) : _self(self), _count(0) {}
+
+  // True if the packet is news: not one of our own, and newer than the
+  // last one from its sender (or from a new sender / boot)
+  bool accept(const PeerPacket& packet, uint32_t nowMs);
+  bool isLeader(uint32_t nowMs) const;
+  // Peers heard within TIMEOUT_MS
+  size_t alive(uint32_t nowMs) const;
+
+private:
+  struct Peer {
+    uint32_t id;
+    uint32_t epoch;
+    uint32_t seq;
+    uint32_t heardMs;
+  };
+
+  uint32_t _self;
+  Peer _peers[MAX_PEERS];
+  size_t _count;
+};
+
+#endif // PEER_PACKET_H
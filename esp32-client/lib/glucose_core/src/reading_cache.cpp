@@ -0,0 +1,66 @@
+#include "reading_cache.h"
+
+#include <string.h>
+#include "fnv1a.h"
+
+// Bump when ReadingCache changes
+static const uint16_t LAYOUT = 1;
+
+// Bitwise CRC-32 (IEEE): a few hundred bytes once per reading, not worth
+// a table
+static uint32_t crc32(const uint8_t* data, size_t len) {
+  uint32_t crc = 0xffffffffu;
+  while (len--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t cacheCrc(const ReadingCache& cache) {
+  return crc32(reinterpret_cast<const uint8_t*>(&cache), offsetof(ReadingCache, crc));
+}
+
+static bool valid(const ReadingCache& cache, uint32_t owner) {
+  return cache.owner == owner && cache.layout == LAYOUT && cache.count <= READING_CACHE_ENTRIES &&
+         cache.crc == cacheCrc(cache);
+}
+
+uint32_t readingCacheOwner(const char* userId) {
+  return fnv1a(userId);
+}
+
+void readingCacheStore(ReadingCache& cache, uint32_t owner, const GlucoseHistory& history) {
+  memset(&cache, 0, sizeof(cache)); // padding too, it is in the CRC
+  size_t count = history.size() < READING_CACHE_ENTRIES ? history.size() : READING_CACHE_ENTRIES;
+  size_t first = history.size() - count;
+  for (size_t i = 0; i < count; ++i) {
+    HistoryEntry entry = history.at(first + i);
+    cache.timestamps[i] = entry.timestamp;
+    cache.mgdl[i] = entry.mgdl;
+  }
+  cache.owner = owner;
+  cache.layout = LAYOUT;
+  cache.count = (uint16_t)count;
+  cache.crc = cacheCrc(cache);
+}
+
+bool readingCacheRestore(const ReadingCache& cache, uint32_t owner, GlucoseHistory& history) {
+  if (!valid(cache, owner) || cache.count == 0) {
+    return false;
+  }
+  history.clear();
+  for (size_t i = 0; i < cache.count; ++i) {
+    history.add(cache.timestamps[i], cache.mgdl[i]);
+  }
+  return history.size() > 0;
+}
+
+uint32_t readingCacheNewest(const ReadingCache& cache, uint32_t owner) {
+  if (!valid(cache, owner) || cache.count == 0) {
+    return 0;
+  }
+  return cache.timestamps[cache.count - 1];
+}
@@ -0,0 +1,45 @@
+// lib/glucose_core/src/reading_cache.h - newest readings kept across resets
+#ifndef READING_CACHE_H
+#define READING_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "glucose_history.h"
+
+// Readings per user in the cache: enough for the trend and the low
+// prediction; the cold-boot backfill brings the rest of the 24 h back
+#ifndef READING_CACHE_ENTRIES
+#define READING_CACHE_ENTRIES 36 // 3 h at 5-minute cadence
+#endif
+static_assert(READING_CACHE_ENTRIES > GlucoseHistory::TREND_WINDOW &&
+                READING_CACHE_ENTRIES <= GlucoseHistory::CAPACITY,
+              "READING_CACHE_ENTRIES must hold a trend window and fit the history");
+
+// Fixed-size copy of a history's newest entries, meant for memory that
+// outlives the firmware's RAM: RTC memory that is not initialised at boot
+// (survives resets that keep the power on, e.g. a watchdog or a panic)
+// and an NVS blob (survives power loss and brownouts). Whatever is in there may be garbage or another
+// user's, so it carries the owner and a CRC.
+struct ReadingCache {
+  uint32_t owner; // readingCacheOwner() of the user id
+  uint16_t layout;
+  uint16_t count;
+  uint32_t timestamps[READING_CACHE_ENTRIES];
+  uint16_t mgdl[READING_CACHE_ENTRIES];
+  uint32_t crc; // CRC-32 of everything above
+};
+
+// Tag of a user id, so a cache is not restored for someone else after
+// GLUCOSE_USERS changed
+uint32_t readingCacheOwner(const char* userId);
+
+// Copies the newest entries of history; an empty history stores an empty
+// (but valid) cache
+void readingCacheStore(ReadingCache& cache, uint32_t owner, const GlucoseHistory& history);
+// Replaces history with the cached entries; false (history untouched) if
+// the cache is torn, of another layout or owner, or empty
+bool readingCacheRestore(const ReadingCache& cache, uint32_t owner, GlucoseHistory& history);
+// Timestamp of the newest cached entry, 0 when empty or invalid
+uint32_t readingCacheNewest(const ReadingCache& cache, uint32_t owner);
+
+#endif // READING_CACHE_H
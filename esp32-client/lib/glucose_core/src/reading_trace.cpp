@@ -0,0 +1,120 @@
+#include "reading_trace.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const char* const SOURCE_NAMES[] = { "poll", "stream", "push", "peer", "any" };
+static const char* const STAGE_NAMES[] = { "publish", "deliver", "receive", "display", "total" };
+static_assert(sizeof(SOURCE_NAMES) / sizeof(SOURCE_NAMES[0]) == (size_t)TraceSource::Any + 1,
+              "SOURCE_NAMES out of sync with TraceSource");
+static_assert(sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]) == (size_t)TraceStage::COUNT,
+              "STAGE_NAMES out of sync with TraceStage");
+
+const char* traceSourceName(TraceSource source) {
+  return SOURCE_NAMES[(size_t)source];
+}
+
+const char* traceStageName(TraceStage stage) {
+  return STAGE_NAMES[(size_t)stage];
+}
+
+// to - from, 0 if negative, capped below TRACE_NONE
+static uint32_t stretch(uint64_t fromMs, uint64_t toMs) {
+  if (toMs <= fromMs) {
+    return 0;
+  }
+  return (uint32_t)std::min<uint64_t>(toMs - fromMs, TRACE_NONE - 1);
+}
+
+uint32_t traceStageMs(const ReadingTrace& trace, TraceStage stage) {
+  uint64_t sensorMs = (uint64_t)trace.sensorAt * 1000;
+  uint64_t publishedMs = (uint64_t)trace.publishedAt * 1000;
+  switch (stage) {
+    case TraceStage::Publish:
+      return trace.publishedAt != 0 ? stretch(sensorMs, publishedMs) : TRACE_NONE;
+    case TraceStage::Deliver:
+      return trace.publishedAt != 0 ? stretch(publishedMs, trace.receivedAtMs) : TRACE_NONE;
+    case TraceStage::Receive:
+      return stretch(sensorMs, trace.receivedAtMs);
+    case TraceStage::Display:
+      return trace.displayMs;
+    case TraceStage::Total:
+      if (trace.displayMs == TRACE_NONE) {
+        return TRACE_NONE;
+      }
+      return stretch(sensorMs, trace.receivedAtMs + trace.displayMs);
+    default:
+      return TRACE_NONE;
+  }
+}
+
+void TraceWindow::clear() {
+  memset(this, 0, sizeof(*this));
+}
+
+void TraceWindow::add(const ReadingTrace& trace) {
+  for (size_t s = 0; s < (size_t)TraceStage::COUNT; ++s) {
+    _ms[s][_head] = traceStageMs(trace, (TraceStage)s);
+  }
+  _source[_head] = trace.source;
+  _head = (uint8_t)((_head + 1) % TRACE_WINDOW);
+  if (_count < TRACE_WINDOW) {
+    ++_count;
+  }
+}
+
+TraceStats TraceWindow::stats(TraceStage stage, TraceSource source) const {
+  uint32_t sorted[TRACE_WINDOW];
+  size_t n = 0;
+  for (size_t i = 0; i < _count; ++i) {
+    uint32_t ms = _ms[(size_t)stage][i];
+    if (ms != TRACE_NONE && (source == TraceSource::Any || _source[i] == source)) {
+      sorted[n++] = ms;
+    }
+  }
+  TraceStats stats = { (uint16_t)n, 0, 0, 0, 0 };
+  if (n == 0) {
+    return stats;
+  }
+  std::sort(sorted, sorted + n);
+  // nearest rank: the smallest value with at least p % of the samples at or below it
+  auto rank = [&](uint32_t p) { return sorted[(n * p + 99) / 100 - 1]; };
+  stats.p50Ms = rank(50);
+  stats.p90Ms = rank(90);
+  stats.p99Ms = rank(99);
+  stats.maxMs = sorted[n - 1];
+  return stats;
+}
+
+// snprintf at out + len, keeping len the would-be length once out is full
+static void append(char* out, size_t size, size_t& len, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+static void append(char* out, size_t size, size_t& len, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(len < size ? out + len : nullptr, len < size ? size - len : 0, format, args);
+  va_end(args);
+  if (n > 0) {
+    len += (size_t)n;
+  }
+}
+
+size_t traceJson(const TraceWindow& window, uint32_t at, char* out, size_t size) {
+  size_t len = 0;
+  append(out, size, len, "{\"at\":%lu,\"n\":%u,\"sources\":{", (unsigned long)at, (unsigned)window.size());
+  for (size_t s = 0; s < (size_t)TraceSource::Any; ++s) {
+    TraceStats stats = window.stats(TraceStage::Receive, (TraceSource)s);
+    append(out, size, len, "%s\"%s\":%u", s ? "," : "", SOURCE_NAMES[s], (unsigned)stats.count);
+  }
+  append(out, size, len, "}");
+  for (size_t s = 0; s < (size_t)TraceStage::COUNT; ++s) {
+    TraceStats stats = window.stats((TraceStage)s);
+    append(out, size, len, ",\"%s\":{\"n\":%u,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}", STAGE_NAMES[s],
+           (unsigned)stats.count, (unsigned long)stats.p50Ms, (unsigned long)stats.p90Ms,
+           (unsigned long)stats.p99Ms, (unsigned long)stats.maxMs);
+  }
+  append(out, size, len, "}");
+  return len;
+}
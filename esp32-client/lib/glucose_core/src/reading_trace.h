@@ -0,0 +1,83 @@
+// lib/glucose_core/src/reading_trace.h - end-to-end latency of each reading
+#ifndef READING_TRACE_H
+#define READING_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Readings per user the percentiles are taken over
+#ifndef TRACE_WINDOW
+#define TRACE_WINDOW 48 // 4 h at 5-minute cadence
+#endif
+static_assert(TRACE_WINDOW > 0 && TRACE_WINDOW <= 255, "TRACE_WINDOW must be 1..255");
+
+// How the reading reached the device
+enum class TraceSource : uint8_t {
+  Poll,   // GET of latest.json or the compact record
+  Stream, // RTDB event stream
+  Push,   // POSTed by the ingestor on the LAN
+  Peer,   // multicast by another display
+  Any,    // stats() over every source
+};
+
+// Stretches between the four timestamps of a trace. LEDs follow a reading
+// as soon as it arrives, so Receive is how late they are; Total is how
+// late the display is.
+enum class TraceStage : uint8_t {
+  Publish, // sensor -> ingestor wrote it to RTDB (fetched_at_unix_ms)
+  Deliver, // RTDB -> device
+  Receive, // sensor -> device
+  Display, // device -> on the display (waits for a multi-user cycle)
+  Total,   // sensor -> on the display
+  COUNT
+};
+
+const uint32_t TRACE_NONE = UINT32_MAX; // stage not measured for a reading
+
+struct ReadingTrace {
+  uint32_t sensorAt;     // main.timestamp, unix s
+  uint32_t publishedAt;  // ingestor's fetched_at_unix_ms in s, 0 if unknown
+  uint64_t receivedAtMs; // device clock (SNTP), unix ms
+  uint32_t displayMs;    // receive until it was shown, TRACE_NONE if never
+  TraceSource source;
+};
+
+// Duration of a stage; TRACE_NONE if a timestamp is missing. Clocks that
+// disagree can make a stretch negative, which counts as 0.
+uint32_t traceStageMs(const ReadingTrace& trace, TraceStage stage);
+
+struct TraceStats {
+  uint16_t count;
+  uint32_t p50Ms, p90Ms, p99Ms, maxMs; // 0 when count is 0
+};
+
+// The stage durations of the last TRACE_WINDOW readings. Exact
+// percentiles rather than LatencyHistogram's log2 buckets: the stretches
+// run from milliseconds to many minutes, and a few dozen samples make
+// sorting a copy cheap. All zero is an empty window, so it can live in
+// RTC memory across deep sleep.
+class TraceWindow {
+public:
+  void clear();
+  void add(const ReadingTrace& trace);
+
+  size_t size() const { return _count; }
+  // Nearest-rank percentiles of a stage, over one source or all
+  TraceStats stats(TraceStage stage, TraceSource source = TraceSource::Any) const;
+
+private:
+  uint32_t _ms[(size_t)TraceStage::COUNT][TRACE_WINDOW];
+  TraceSource _source[TRACE_WINDOW];
+  uint8_t _head; // next slot to write
+  uint8_t _count;
+};
+
+// "poll", "receive", ... as used in the reports
+const char* traceSourceName(TraceSource source);
+const char* traceStageName(TraceStage stage);
+
+// {"at":<unix s>,"n":..,"sources":{"poll":..,...},"receive":{"n":..,"p50":..,"p90":..,"p99":..,"max":..},...}
+// in ms; returns the length like snprintf (output cut to size)
+size_t traceJson(const TraceWindow& window, uint32_t at, char* out, size_t size);
+
+#endif // READING_TRACE_H
@@ -0,0 +1,83 @@
+#include "console.h"
+
+#include "log.h"
+#include "metrics.h"
+#include "settings_store.h"
+#include "trace_report.h"
+
+// long enough for "url " and a full SETTINGS_URL_SIZE url
+static const size_t LINE_SIZE = SETTINGS_URL_SIZE + 32;
+
+static DeviceSettings draft; // what "save" will store
+
+void consoleBegin(const DeviceSettings& settings) {
+  draft = settings;
+}
+
+static void restart() {
+  Serial.print("restartuji...\n");
+  logFlush();
+  Serial.flush();
+  ESP.restart();
+}
+
+static void run(const char* line) {
+  if (strcmp(line, "metrics") == 0) {
+    metricsDump(Serial);
+    return;
+  }
+  if (strcmp(line, "trace") == 0) {
+    traceDump(Serial);
+    return;
+  }
+  switch (settingsCommand(draft, line)) {
+    case SettingsCommand::None:
+      if (line[0] != '\0') {
+        Serial.printf("neznamy prikaz: %s\n", line);
+      }
+      break;
+    case SettingsCommand::Show:
+      settingsPrint(draft, Serial);
+      break;
+    case SettingsCommand::Changed:
+      Serial.print("ok (ulozi 'save')\n");
+      break;
+    case SettingsCommand::Invalid:
+      Serial.print("neplatne argumenty\n");
+      break;
+    case SettingsCommand::Save:
+      if (!settingsSave(draft)) {
+        Serial.print("ulozeni selhalo\n");
+        break;
+      }
+      restart();
+      break;
+    case SettingsCommand::Reset:
+      settingsErase();
+      restart();
+      break;
+  }
+}
+
+void consolePoll() {
+  static char line[LINE_SIZE];
+  static size_t len = 0;
+  static bool overlong = false;
+  while (Serial.available() > 0) {
+    char c = (char)Serial.read();
+    if (c == '\r' || c == '\n') {
+      line[len] = '\0';
+      if (overlong) {
+        Serial.print("prilis dlouhy radek\n");
+      } else {
+        run(line);
+      }
+      len = 0;
+      overlong = false;
+    } else if (len < sizeof(line) - 1) {
+      line[len++] = c;
+    } else {
+      overlong = true;
+    }
+  }
+}
@@ -0,0 +1,14 @@
+#include "device_id.h"
+
+uint32_t deviceId() {
+  uint64_t mac = ESP.getEfuseMac();
+  return (uint32_t)(mac >> 16) ^ (uint32_t)mac;
+}
+
+const char* deviceName() {
+  static char name[24] = "";
+  if (name[0] == '\0') {
+    snprintf(name, sizeof(name), "gluco-watch-%06lx", (unsigned long)(deviceId() & 0xffffff));
+  }
+  return name;
+}
@@ -0,0 +1,82 @@
+#include "display_backend.h"
+
+#if GLUCOSE_DISPLAY == DISPLAY_EPAPER
+#include <SPI.h>
+
+EpaperBackend::EpaperBackend()
+    : _epd(EPAPER_PANEL(EPAPER_CS, EPAPER_DC, EPAPER_RST, EPAPER_BUSY)), _layouts(), _slots(1), _partials(0) {}
+
+// After a deep sleep wake-up the panel still shows the last image, so the
+// first refresh may be a partial one
+void EpaperBackend::start(bool keepImage, uint8_t slots) {
+  SPI.begin(EPAPER_SCK, -1, EPAPER_MOSI, EPAPER_CS);
+  _epd.epd2.selectSPI(SPI, SPISettings(4000000, MSBFIRST, SPI_MODE0));
+  _epd.init(0, !keepImage);
+  _epd.setRotation(1); // landscape
+  _slots = slots;
+  for (uint8_t i = 0; i < _slots; ++i) {
+    _layouts[i] = gfxLayout(gfxRow(_epd.width(), _epd.height(), i, _slots));
+  }
+  _partials = 0;
+}
+
+bool EpaperBackend::window(const GfxRect& r) {
+  if (_partials >= EPAPER_FULL_REFRESH_EVERY) {
+    _epd.setFullWindow();
+    _partials = 0;
+    return true;
+  }
+  _epd.setPartialWindow(r.x, r.y, r.w, r.h);
+  ++_partials;
+  return false;
+}
+
+// The whole view is drawn on every page; GxEPD2 clips it to the window,
+// so pixels around a region that is not itself dirty come out right too.
+// A full refresh takes in the other rows as well, so they are redrawn
+// from the views last shown in them.
+void EpaperBackend::drawView(const DisplayView& view, uint8_t dirty, uint8_t slot) {
+  bool full = window(gfxBounds(_layouts[slot], dirty));
+  uint8_t number = _slots > 1 ? slot + 1 : 0;
+  _epd.firstPage();
+  do {
+    _epd.fillScreen(GxEPD_WHITE);
+    gfxDrawView(_epd, _layouts[slot], view, GxEPD_BLACK, number);
+    for (uint8_t i = 0; full && i < _slots; ++i) {
+      const DisplayView* other = slotView(i);
+      if (i != slot && other != nullptr) {
+        gfxDrawView(_epd, _layouts[i], *other, GxEPD_BLACK, i + 1);
+      }
+    }
+  } while (_epd.nextPage());
+  _epd.powerOff();
+}
+
+void EpaperBackend::drawLabel(uint8_t number) {
+  window(GfxRect{ 0, 0, _epd.width(), _epd.height() });
+  _epd.firstPage();
+  do {
+    _epd.fillScreen(GxEPD_WHITE);
+    gfxDrawLabel(_epd, number, GxEPD_BLACK);
+  } while (_epd.nextPage());
+  _epd.powerOff();
+}
+
+void EpaperBackend::drawBlank() {
+  window(GfxRect{ 0, 0, _epd.width(), _epd.height() });
+  _epd.firstPage();
+  do {
+    _epd.fillScreen(GxEPD_WHITE);
+  } while (_epd.nextPage());
+  _epd.powerOff();
+}
+
+// The image needs no power; off only puts the controller into its
+// deepest sleep (the next refresh wakes it through RST)
+void EpaperBackend::power(bool on) {
+  if (!on) {
+    _epd.hibernate();
+  }
+}
+
+#endif
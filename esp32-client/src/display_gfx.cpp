@@ -0,0 +1,164 @@
+#include "display_backend.h"
+
+#if GLUCOSE_DISPLAY == DISPLAY_SSD1306 || GLUCOSE_DISPLAY == DISPLAY_EPAPER
+#include "display_gfx.h"
+
+#include <algorithm>
+
+// Adafruit_GFX's built-in font: 5x7 glyphs in 6x8 cells, scaled by the
+// text size
+static const int16_t CHAR_W = 6;
+static const int16_t CHAR_H = 8;
+static const size_t VALUE_CHARS = 4; // "12.0", "300"
+// Below this a sparkline is a blur of a few rows of pixels
+static const int16_t SPARK_MIN_AREA_H = 48;
+
+static int16_t align8(int16_t v) {
+  return v & ~7;
+}
+
+GfxLayout gfxLayout(const GfxRect& area) {
+  int16_t top = area.h < SPARK_MIN_AREA_H ? area.h : align8(area.h * 5 / 8);
+  int16_t valueW = align8(area.w * 5 / 8);
+  int16_t trendW = align8(area.w / 4);
+  GfxLayout layout;
+  layout.value = GfxRect{ area.x, area.y, valueW, top };
+  layout.trend = GfxRect{ (int16_t)(area.x + valueW), area.y, trendW, top };
+  layout.stale = GfxRect{ (int16_t)(area.x + valueW + trendW), area.y, (int16_t)(area.w - valueW - trendW), top };
+  layout.spark = GfxRect{ area.x, (int16_t)(area.y + top), area.w, (int16_t)(area.h - top) };
+  return layout;
+}
+
+GfxRect gfxRow(int16_t width, int16_t height, uint8_t index, uint8_t count) {
+  int16_t y0 = align8((int16_t)(height * index / count));
+  int16_t y1 = index + 1 >= count ? height : align8((int16_t)(height * (index + 1) / count));
+  return GfxRect{ 0, y0, width, (int16_t)(y1 - y0) };
+}
+
+GfxRect gfxBounds(const GfxLayout& layout, uint8_t regions) {
+  const GfxRect* rects[] = { &layout.value, &layout.trend, &layout.stale, &layout.spark };
+  int16_t x0 = INT16_MAX, y0 = INT16_MAX, x1 = 0, y1 = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    if (regions & (1 << i)) {
+      const GfxRect& r = *rects[i];
+      x0 = std::min(x0, r.x);
+      y0 = std::min(y0, r.y);
+      x1 = std::max(x1, (int16_t)(r.x + r.w));
+      y1 = std::max(y1, (int16_t)(r.y + r.h));
+    }
+  }
+  if (x0 > x1) {
+    return GfxRect{ 0, 0, 0, 0 };
+  }
+  return GfxRect{ x0, y0, (int16_t)(x1 - x0), (int16_t)(y1 - y0) };
+}
+
+// Text in the built-in font, as large as fits chars cells, centred
+static void drawCentred(Adafruit_GFX& gfx, const GfxRect& r, const char* text, size_t chars, uint16_t color) {
+  int16_t size = std::max<int16_t>(1, std::min<int16_t>(r.h / CHAR_H, r.w / (CHAR_W * chars)));
+  int16_t len = (int16_t)strlen(text);
+  gfx.setTextSize(size);
+  gfx.setTextColor(color);
+  gfx.setTextWrap(false);
+  gfx.setCursor(r.x + (r.w - len * CHAR_W * size) / 2, r.y + (r.h - CHAR_H * size) / 2);
+  gfx.print(text);
+}
+
+// Direction in tenths of the arrow's length, screen y pointing down
+static bool trendDirection(Trend trend, int16_t& dx, int16_t& dy) {
+  switch (trend) {
+    case Trend::RisingFast: dx = 0; dy = -10; return true;
+    case Trend::Rising: dx = 7; dy = -7; return true;
+    case Trend::Flat: dx = 10; dy = 0; return true;
+    case Trend::Falling: dx = 7; dy = 7; return true;
+    case Trend::FallingFast: dx = 0; dy = 10; return true;
+    default: return false;
+  }
+}
+
+static void drawTrend(Adafruit_GFX& gfx, const GfxRect& r, Trend trend, uint16_t color) {
+  int16_t ux, uy;
+  if (!trendDirection(trend, ux, uy)) {
+    return;
+  }
+  int16_t len = std::min(r.w, r.h) / 2 - 2; // centre to tip
+  int16_t cx = r.x + r.w / 2, cy = r.y + r.h / 2;
+  int16_t tipX = cx + len * ux / 10, tipY = cy + len * uy / 10;
+  // head: back from the tip by half the length, wings across it
+  int16_t baseX = tipX - len * ux / 20, baseY = tipY - len * uy / 20;
+  int16_t wingX = -len * uy / 25, wingY = len * ux / 25;
+  int16_t tailX = cx - len * ux / 10, tailY = cy - len * uy / 10;
+  bool steep = abs(uy) > abs(ux);
+  for (int16_t w = -1; w <= 1; ++w) { // 3 pixels wide shaft
+    int16_t ox = steep ? w : 0, oy = steep ? 0 : w;
+    gfx.drawLine(tailX + ox, tailY + oy, baseX + ox, baseY + oy, color);
+  }
+  gfx.fillTriangle(tipX, tipY, baseX + wingX, baseY + wingY, baseX - wingX, baseY - wingY, color);
+}
+
+static int16_t sparkY(const GfxRect& r, uint8_t level) {
+  return r.y + r.h - 1 - (int16_t)((int32_t)(level - 1) * (r.h - 1) / (SPARKLINE_TOP - 1));
+}
+
+static void drawSparkline(Adafruit_GFX& gfx, const GfxRect& r, const Sparkline& spark, uint16_t color) {
+  if (r.h < 2) {
+    return; // left out of the layout
+  }
+  // dotted threshold lines
+  const uint8_t lines[] = { sparklineLevel(CONFIG.lowMgdl), sparklineLevel(CONFIG.highMgdl) };
+  for (uint8_t level : lines) {
+    int16_t y = sparkY(r, level);
+    for (int16_t x = r.x; x < r.x + r.w; x += 4) {
+      gfx.drawPixel(x, y, color);
+    }
+  }
+  int16_t prevX = 0, prevY = 0;
+  bool prev = false;
+  for (size_t i = 0; i < SPARKLINE_POINTS; ++i) {
+    if (spark.level[i] == SPARKLINE_GAP) {
+      prev = false;
+      continue;
+    }
+    int16_t x = r.x + (int16_t)(i * (r.w - 1) / (SPARKLINE_POINTS - 1));
+    int16_t y = sparkY(r, spark.level[i]);
+    if (prev) {
+      gfx.drawLine(prevX, prevY, x, y, color);
+    } else {
+      gfx.drawPixel(x, y, color);
+    }
+    prevX = x;
+    prevY = y;
+    prev = true;
+  }
+}
+
+void gfxDrawView(Adafruit_GFX& gfx, const GfxLayout& layout, const DisplayView& view, uint16_t color,
+                 uint8_t number) {
+  char text[8];
+  glucoseText(text, sizeof(text), view.mgdl);
+  drawCentred(gfx, layout.value, text, VALUE_CHARS, color);
+  if (number != 0) {
+    gfx.setTextSize(layout.value.h >= 4 * CHAR_H ? 2 : 1);
+    gfx.setCursor(layout.value.x + 1, layout.value.y + 1);
+    gfx.print((unsigned)number);
+  }
+  if (view.mgdl != GLUCOSE_NONE && CONFIG.display == DisplayMode::ValueTrend) {
+    drawTrend(gfx, layout.trend, view.trend, color);
+  }
+  if (view.stale) {
+    // half height: a marker, not a second value
+    GfxRect mark = layout.stale;
+    mark.y += mark.h / 4;
+    mark.h /= 2;
+    drawCentred(gfx, mark, "?", 1, color);
+  }
+  drawSparkline(gfx, layout.spark, view.spark, color);
+}
+
+void gfxDrawLabel(Adafruit_GFX& gfx, uint8_t number, uint16_t color) {
+  char text[8];
+  snprintf(text, sizeof(text), "U %u", (unsigned)number);
+  drawCentred(gfx, GfxRect{ 0, 0, gfx.width(), gfx.height() }, text, strlen(text), color);
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include "display_backend.h"
+
+#if GLUCOSE_DISPLAY == DISPLAY_SSD1306
+#include <Wire.h>
+#include "log.h"
+
+static const int16_t WIDTH = 128;
+static const int16_t HEIGHT = 64;
+
+Ssd1306Backend::Ssd1306Backend() : _oled(WIDTH, HEIGHT, &Wire, -1), _layout(gfxLayout(GfxRect{ 0, 0, WIDTH, HEIGHT })) {}
+
+void Ssd1306Backend::start(bool, uint8_t) {
+  Wire.begin(OLED_SDA, OLED_SCL);
+  Wire.setClock(400000);
+  if (!_oled.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS)) {
+    LOG_ERROR("OLED displej neodpovida (adresa 0x%02x)", OLED_ADDRESS);
+  }
+}
+
+void Ssd1306Backend::drawView(const DisplayView& view, uint8_t, uint8_t) {
+  _oled.clearDisplay();
+  gfxDrawView(_oled, _layout, view, SSD1306_WHITE);
+  _oled.display();
+}
+
+void Ssd1306Backend::drawLabel(uint8_t number) {
+  _oled.clearDisplay();
+  gfxDrawLabel(_oled, number, SSD1306_WHITE);
+  _oled.display();
+}
+
+void Ssd1306Backend::drawBlank() {
+  _oled.clearDisplay();
+  _oled.display();
+}
+
+void Ssd1306Backend::power(bool on) {
+  _oled.ssd1306_command(on ? SSD1306_DISPLAYON : SSD1306_DISPLAYOFF);
+}
+
+#endif
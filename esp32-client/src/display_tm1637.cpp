@@ -0,0 +1,35 @@
+#include "display_backend.h"
+
+#if GLUCOSE_DISPLAY == DISPLAY_TM1637
+
+static const uint8_t BRIGHTNESS = 0x0f;
+
+Tm1637Backend::Tm1637Backend() : _display(TM1637_CLK, TM1637_DIO) {}
+
+void Tm1637Backend::start(bool, uint8_t) {
+  _display.setBrightness(BRIGHTNESS);
+}
+
+void Tm1637Backend::drawView(const DisplayView& view, uint8_t, uint8_t) {
+  _display.setSegments(view.frame.seg);
+}
+
+void Tm1637Backend::drawLabel(uint8_t number) {
+  _display.setSegments(userLabelFrame(number).seg);
+}
+
+void Tm1637Backend::drawBlank() {
+  const uint8_t off[4] = { 0, 0, 0, 0 };
+  _display.setSegments(off);
+}
+
+// The brightness byte only goes out with the next frame, so switching off
+// sends a blank one
+void Tm1637Backend::power(bool on) {
+  _display.setBrightness(BRIGHTNESS, on);
+  if (!on) {
+    drawBlank();
+  }
+}
+
+#endif
@@ -0,0 +1,230 @@
+#include "glucose_stream.h"
+
+#include <ArduinoJson.h>
+#include "latest_json.h"
+#include "log.h"
+
+GlucoseStream::GlucoseStream(HttpsSession& session, const char* url)
+  : _session(session), _url(url), _open(false), _chunked(false),
+    _lastActivityMs(0) {
+  resetParser();
+}
+
+void GlucoseStream::resetParser() {
+  _chunkState = CHUNK_SIZE;
+  _chunkRemaining = 0;
+  _dataLen = 0;
+  _len = 0;
+  _overflow = false;
+  _name[0] = '\0';
+  _publishedAt = 0;
+}
+
+bool GlucoseStream::open() {
+  close();
+  if (!_session.begin(_url)) {
+    LOG_ERROR("Stream: HTTP begin selhalo");
+    return false;
+  }
+  HTTPClient& http = _session.http();
+  // RTDB may redirect the stream to the server that owns the data
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+  http.addHeader("Accept", "text/event-stream");
+  const char* headerKeys[] = { "Transfer-Encoding" };
+  http.collectHeaders(headerKeys, 1);
+
+  int httpCode = _session.GET();
+  if (httpCode != HTTP_CODE_OK) {
+    LOG_WARN("Stream: otevreni selhalo, kod: %d", httpCode);
+    _session.reset();
+    return false;
+  }
+
+  _chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+  resetParser();
+  _open = true;
+  _lastActivityMs = millis();
+  LOG_INFO("Stream: pripojeno");
+  return true;
+}
+
+void GlucoseStream::close() {
+  if (_open) {
+    _session.reset();
+    _open = false;
+  }
+}
+
+bool GlucoseStream::connected() {
+  if (_open && !_session.http().connected()) {
+    LOG_WARN("Stream: spojeni ukonceno serverem");
+    close();
+  }
+  return _open;
+}
+
+void GlucoseStream::waitForData(unsigned long timeoutMs) {
+  unsigned long start = millis();
+  while (millis() - start < timeoutMs) {
+    if (_open && _session.http().getStream().available() > 0) {
+      return;
+    }
+    delay(10);
+  }
+}
+
+bool GlucoseStream::poll(GlucoseReading& reading, uint32_t& publishedAt) {
+  if (!connected()) {
+    return false;
+  }
+
+  WiFiClient& stream = _session.http().getStream();
+  bool updated = false;
+  int avail = stream.available();
+  if (avail > 0) {
+    _lastActivityMs = millis();
+  }
+  while (avail-- > 0) {
+    int c = stream.read();
+    if (c < 0) {
+      break;
+    }
+    if (!_chunked) {
+      updated |= feed((char)c, reading);
+      continue;
+    }
+    switch (_chunkState) {
+      case CHUNK_SIZE:
+        if (c == '\n') {
+          _chunkState = _chunkRemaining > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+        } else if (isxdigit(c)) {
+          _chunkRemaining = _chunkRemaining * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+        }
+        break;
+      case CHUNK_DATA:
+        updated |= feed((char)c, reading);
+        if (--_chunkRemaining == 0) {
+          _chunkState = CHUNK_TRAILER;
+        }
+        break;
+      case CHUNK_TRAILER:
+        // CRLF after the chunk data
+        if (c == '\n') {
+          _chunkState = CHUNK_SIZE;
+        }
+        break;
+    }
+  }
+
+  if (millis() - _lastActivityMs > IDLE_TIMEOUT_MS) {
+    LOG_WARN("Stream: zadna data (ani keep-alive), znovu pripojuji");
+    close();
+  }
+  publishedAt = _publishedAt;
+  return updated;
+}
+
+bool GlucoseStream::feed(char c, GlucoseReading& reading) {
+  if (c == '\n') {
+    bool updated = !_overflow && processLine(reading);
+    if (_overflow) {
+      // drop the oversized line and the event it belongs to
+      _overflow = false;
+      _dataLen = 0;
+      _len = 0;
+      _name[0] = '\0';
+    }
+    return updated;
+  }
+  if (c == '\r') {
+    return false;
+  }
+  if (_len >= BUFFER_SIZE - 1) {
+    _overflow = true;
+    return false;
+  }
+  _buf[_len++] = c;
+  return false;
+}
+
+bool GlucoseStream::processLine(GlucoseReading& reading) {
+  char* line = _buf + _dataLen;
+  size_t lineLen = _len - _dataLen;
+
+  if (lineLen == 0) {
+    // blank line terminates the event
+    bool updated = dispatch(reading);
+    _dataLen = 0;
+    _len = 0;
+    _name[0] = '\0';
+    return updated;
+  }
+
+  if (lineLen >= 6 && strncmp(line, "event:", 6) == 0) {
+    const char* value = line + 6;
+    size_t valueLen = lineLen - 6;
+    if (valueLen > 0 && *value == ' ') {
+      value++;
+      valueLen--;
+    }
+    if (valueLen >= NAME_SIZE) {
+      valueLen = NAME_SIZE - 1;
+    }
+    memcpy(_name, value, valueLen);
+    _name[valueLen] = '\0';
+  } else if (lineLen >= 5 && strncmp(line, "data:", 5) == 0) {
+    size_t skip = (lineLen > 5 && line[5] == ' ') ? 6 : 5;
+    size_t valueLen = lineLen - skip;
+    size_t dst = _dataLen;
+    if (_dataLen > 0) {
+      // multi-line data fields are joined with '\n' (SSE spec)
+      _buf[dst++] = '\n';
+    }
+    memmove(_buf + dst, line + skip, valueLen);
+    _dataLen = dst + valueLen;
+  }
+  // other fields (id:, retry:, comments) are not used by RTDB
+  _len = _dataLen;
+  return false;
+}
+
+bool GlucoseStream::dispatch(GlucoseReading& reading) {
+  if (strcmp(_name, "keep-alive") == 0 || _name[0] == '\0') {
+    return false;
+  }
+  if (strcmp(_name, "cancel") == 0 || strcmp(_name, "auth_revoked") == 0) {
+    LOG_WARN("Stream: server ukoncil stream (%s)", _name);
+    close();
+    return false;
+  }
+  if (strcmp(_name, "put") != 0 && strcmp(_name, "patch") != 0) {
+    return false;
+  }
+
+  DynamicJsonDocument doc(1024);
+  DeserializationError err = deserializeJson(doc, _buf, _dataLen);
+  if (err) {
+    LOG_ERROR("Stream: JSON parse error: %s", err.c_str());
+    return false;
+  }
+
+  // Event data is relative to the streamed node (users/{uid}/latest)
+  const char* path = doc["path"] | "";
+  JsonVariant data = doc["data"];
+  // only a write of the whole node (the ingestor's set()) or a patch at
+  // its root carries fetched_at_unix_ms
+  bool read = false;
+  uint32_t publishedAt = 0;
+  if (strcmp(path, "/") == 0) {
+    read = readGlucoseFields(data["main"]["glucose"], data["main"]["timestamp"], reading);
+    publishedAt = readPublishedAt(data);
+  } else if (strcmp(path, "/main") == 0) {
+    read = readGlucoseFields(data["glucose"], data["timestamp"], reading);
+  } else if (strcmp(path, "/main/glucose") == 0) {
+    read = readGlucoseFields(data, JsonVariantConst(), reading);
+  }
+  if (read) {
+    _publishedAt = publishedAt;
+  }
+  return read;
+}
@@ -0,0 +1,122 @@
+#include "https_session.h"
+
+#include <WiFi.h>
+#include <sdkconfig.h>
+#include "metrics.h"
+#include "rtdb_trust.h"
+
+// The handshake (ECDHE, RSA/ECDSA verify, SHA) is what costs time here;
+// the prebuilt Arduino mbedTLS uses the S2's AES/SHA/RSA accelerators, so
+// make it loud if a custom framework build drops them.
+#if !defined(CONFIG_MBEDTLS_HARDWARE_AES) || !defined(CONFIG_MBEDTLS_HARDWARE_SHA) \
+    || !defined(CONFIG_MBEDTLS_HARDWARE_MPI)
+#warning "mbedTLS is built without AES/SHA/MPI hardware acceleration; TLS handshakes will be slow"
+#endif
+// CONFIG_MBEDTLS_SSL_IN_CONTENT_LEN stays at 16 KB: Google's front ends
+// don't negotiate max_fragment_length, so they may send full-size records
+// (the certificate chain alone is ~4 KB) and a smaller buffer would break
+// the handshake.
+
+HttpsSession::HttpsSession(uint16_t timeoutMs)
+  : _timeoutMs(timeoutMs), _configured(false), _port(443) {
+  _host[0] = '\0';
+}
+
+// "https://host[:port]/path" -> host, port
+static void parseHost(const char* url, char* host, size_t size, uint16_t& port) {
+  const char* start = strstr(url, "://");
+  start = start ? start + 3 : url;
+  size_t len = strcspn(start, ":/");
+  if (len >= size) {
+    len = size - 1;
+  }
+  memcpy(host, start, len);
+  host[len] = '\0';
+  port = start[len] == ':' ? (uint16_t)atoi(start + len + 1) : 443;
+}
+
+bool HttpsSession::begin(const char* url) {
+  if (!_configured) {
+#if TLS_INSECURE
+    _client.setInsecure();
+#elif ESP_ARDUINO_VERSION_MAJOR >= 3
+    _client.setCACertBundle(RTDB_CA_BUNDLE, RTDB_CA_BUNDLE_SIZE);
+#else
+    _client.setCACertBundle(RTDB_CA_BUNDLE);
+#endif
+    _client.setHandshakeTimeout((_timeoutMs + 999) / 1000); // seconds
+    _http.setReuse(true);
+    _http.setConnectTimeout(_timeoutMs);
+    _http.setTimeout(_timeoutMs);
+    _configured = true;
+  }
+  parseHost(url, _host, sizeof(_host), _port);
+  // HTTPClient keeps the connected socket across begin()/end() as long as
+  // the host and port stay the same.
+  return _http.begin(_client, url);
+}
+
+// HTTPClient reuses a socket that is already connected, so opening it
+// here only moves the connect out of GET(). On failure GET() tries again
+// and reports the error.
+bool HttpsSession::connect() {
+  IPAddress ip;
+  {
+    PhaseTimer timer(Phase::Dns);
+    if (!WiFi.hostByName(_host, ip)) {
+      return false;
+    }
+  }
+  // connect by name for SNI; lwIP answers the lookup from its cache now
+  PhaseTimer timer(Phase::Connect);
+  bool ok = _client.connect(_host, _port, _timeoutMs) == 1;
+  metricsSampleHeap(); // the TLS session's buffers are allocated now
+  return ok;
+}
+
+int HttpsSession::GET() {
+  return send(nullptr, 0);
+}
+
+int HttpsSession::PUT(const char* body, size_t len) {
+  return send(body, len);
+}
+
+// Errors of a keep-alive socket the server closed while idle. A read
+// timeout is not one of them: the request reached a live server, and
+// sending it again would only double the wait.
+static bool staleSocket(int code) {
+  return code == HTTPC_ERROR_SEND_HEADER_FAILED || code == HTTPC_ERROR_SEND_PAYLOAD_FAILED ||
+         code == HTTPC_ERROR_NOT_CONNECTED || code == HTTPC_ERROR_CONNECTION_LOST;
+}
+
+int HttpsSession::send(const char* body, size_t len) {
+  bool reused = _client.connected();
+  if (!reused) {
+    connect();
+  }
+  uint32_t startUs = micros();
+  int code = body ? _http.PUT((uint8_t*)body, len) : _http.GET();
+  if (reused && staleSocket(code)) {
+    // the idle keep-alive socket was closed by the server; HTTPClient has
+    // already stopped it, so reconnect and send the request again (both
+    // methods are idempotent)
+    connect();
+    startUs = micros();
+    code = body ? _http.PUT((uint8_t*)body, len) : _http.GET();
+  }
+  if (code > 0) {
+    metricsRecord(Phase::FirstByte, micros() - startUs);
+  }
+  metricsSampleHeap();
+  return code;
+}
+
+void HttpsSession::end() {
+  _http.end();
+}
+
+void HttpsSession::reset() {
+  _http.end();
+  _client.stop();
+}
@@ -0,0 +1,52 @@
+#include "lan_push.h"
+
+#include "compact_reading.h"
+#include "log.h"
+
+static WebServer* server = nullptr;
+static const char* pushToken = "";
+static LanPushHandler pushHandler = nullptr;
+
+// Compares in time independent of where the strings differ
+static bool tokenMatches(const String& given) {
+  size_t len = strlen(pushToken);
+  if (len == 0 || given.length() != len) {
+    return false;
+  }
+  uint8_t diff = 0;
+  for (size_t i = 0; i < len; ++i) {
+    diff |= (uint8_t)given[i] ^ (uint8_t)pushToken[i];
+  }
+  return diff == 0;
+}
+
+static void handlePush() {
+  if (!tokenMatches(server->header("X-Push-Token"))) {
+    LOG_WARN("Push: neplatny token");
+    server->send(401, "text/plain", "bad token");
+    return;
+  }
+  // the raw body of a non-form POST
+  const String& body = server->arg("plain");
+  GlucoseReading reading;
+  if (!decodeCompactReading(body.c_str(), body.length(), reading)) {
+    LOG_WARN("Push: neplatny zaznam (%u B)", (unsigned)body.length());
+    server->send(400, "text/plain", "bad record");
+    return;
+  }
+  String uid = server->arg("uid");
+  if (!pushHandler(uid.c_str(), reading)) {
+    server->send(404, "text/plain", "unknown uid");
+    return;
+  }
+  server->send(204, "text/plain", "");
+}
+
+void lanPushRoutes(WebServer& s, const char* token, LanPushHandler handler) {
+  server = &s;
+  pushToken = token;
+  pushHandler = handler;
+  const char* headerKeys[] = { "X-Push-Token" };
+  server->collectHeaders(headerKeys, 1);
+  server->on("/push", HTTP_POST, handlePush);
+}
@@ -0,0 +1,130 @@
+#include "led_engine.h"
+
+#include <driver/ledc.h>
+#include <esp_timer.h>
+
+static const ledc_mode_t MODE = LEDC_LOW_SPEED_MODE; // the only mode of the S2
+static const ledc_timer_t TIMER = LEDC_TIMER_0;
+static const uint32_t PWM_HZ = 5000; // well above visible flicker
+static const uint32_t DUTY_BITS = 10;
+static const uint32_t DUTY_FULL = 1UL << DUTY_BITS; // 100 %: the output stays high
+static const uint32_t FADE_STEP_MS = 20; // 50 updates/s look smooth
+
+// Channel index = LedColor - 1; the mirror LED comes last
+static const size_t COLOR_CHANNELS = 3;
+static const size_t MIRROR_CHANNEL = COLOR_CHANNELS;
+
+static esp_timer_handle_t timer = nullptr;
+static SemaphoreHandle_t lock = nullptr; // state vs. the timer callback
+static LedState state{ LedColor::Off, 0, false };
+static uint32_t patternMs = 0;
+static uint8_t brightness = 100;
+
+// Pattern levels are perceived brightness; LED light output is roughly
+// linear in the duty, so it is squared to make fades and dimming look even
+static uint32_t dutyFor(uint8_t level) {
+  uint32_t scaled = (uint32_t)level * brightness / 100;
+  return scaled * scaled * DUTY_FULL / ((uint32_t)LED_LEVEL_FULL * LED_LEVEL_FULL);
+}
+
+static void setDuty(size_t channel, uint32_t duty) {
+  ledc_set_duty(MODE, (ledc_channel_t)channel, duty);
+  ledc_update_duty(MODE, (ledc_channel_t)channel);
+}
+
+// Call with the lock held
+static void apply() {
+  uint32_t duty = dutyFor(ledPatternLevel(state, patternMs));
+  for (size_t c = 0; c < COLOR_CHANNELS; ++c) {
+    setDuty(c, (size_t)state.color == c + 1 ? duty : 0);
+  }
+  setDuty(MIRROR_CHANNEL, duty);
+}
+
+static uint32_t stepMs() {
+  return state.fade ? FADE_STEP_MS : state.blinkMs;
+}
+
+// Runs in the esp_timer task (priority 22), not in loop()
+static void onStep(void*) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  // a step that waited for the lock while the state turned steady
+  if (state.blinkMs != 0) {
+    patternMs = (patternMs + stepMs()) % (2UL * state.blinkMs);
+    apply();
+  }
+  xSemaphoreGive(lock);
+}
+
+// Call with the lock held
+static void restart() {
+  esp_timer_stop(timer); // fails harmlessly when it wasn't running
+  patternMs = 0;
+  apply();
+  if (state.color != LedColor::Off && state.blinkMs != 0) {
+    esp_timer_start_periodic(timer, stepMs() * 1000ULL);
+  }
+}
+
+void ledEngineBegin(uint8_t redPin, uint8_t yellowPin, uint8_t greenPin, uint8_t mirrorPin) {
+  ledc_timer_config_t timerConfig = {};
+  timerConfig.speed_mode = MODE;
+  timerConfig.duty_resolution = (ledc_timer_bit_t)DUTY_BITS;
+  timerConfig.timer_num = TIMER;
+  timerConfig.freq_hz = PWM_HZ;
+  timerConfig.clk_cfg = LEDC_AUTO_CLK;
+  ledc_timer_config(&timerConfig);
+
+  const uint8_t pins[] = { redPin, yellowPin, greenPin, mirrorPin };
+  for (size_t c = 0; c < sizeof(pins); ++c) {
+    ledc_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = pins[c];
+    channelConfig.speed_mode = MODE;
+    channelConfig.channel = (ledc_channel_t)c;
+    channelConfig.timer_sel = TIMER;
+    channelConfig.duty = 0;
+    channelConfig.hpoint = 0;
+    ledc_channel_config(&channelConfig);
+  }
+
+  lock = xSemaphoreCreateMutex();
+  esp_timer_create_args_t timerArgs = {};
+  timerArgs.callback = onStep;
+  timerArgs.name = "leds";
+  esp_timer_create(&timerArgs, &timer);
+}
+
+void ledEngineShow(const LedState& next) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (next != state) {
+    state = next;
+    restart();
+  }
+  xSemaphoreGive(lock);
+}
+
+void ledEngineSetBrightness(uint8_t percent) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (percent != brightness) {
+    brightness = percent;
+    apply();
+  }
+  xSemaphoreGive(lock);
+}
+
+void ledEngineSuspend() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  esp_timer_stop(timer);
+  for (size_t c = 0; c < COLOR_CHANNELS; ++c) {
+    ledc_stop(MODE, (ledc_channel_t)c, (size_t)state.color == c + 1 ? 1 : 0);
+  }
+  ledc_stop(MODE, (ledc_channel_t)MIRROR_CHANNEL, state.color != LedColor::Off ? 1 : 0);
+  xSemaphoreGive(lock);
+}
+
+// ledc_update_duty() (in apply()) re-enables the stopped outputs
+void ledEngineResume() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  restart();
+  xSemaphoreGive(lock);
+}
@@ -0,0 +1,15 @@
+#include "local_server.h"
+
+static WebServer* server = nullptr;
+
+WebServer& localServerBegin(uint16_t port) {
+  server = new WebServer(port);
+  server->begin();
+  return *server;
+}
+
+void localServerHandle() {
+  if (server != nullptr) {
+    server->handleClient();
+  }
+}
@@ -0,0 +1,98 @@
+#include "log.h"
+
+#include <stdarg.h>
+
+static const size_t LINE_SIZE = 160;
+
+#if LOG_RING_BUFFER
+static char ring[LOG_RING_BUFFER_SIZE];
+static size_t ringHead = 0; // next write position
+static size_t ringTail = 0; // next byte to send
+static uint32_t droppedLines = 0;
+static portMUX_TYPE ringLock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t ringUsed() {
+  return (ringHead + LOG_RING_BUFFER_SIZE - ringTail) % LOG_RING_BUFFER_SIZE;
+}
+
+static void ringPush(const char* line, size_t len) {
+  portENTER_CRITICAL(&ringLock);
+  if (len < LOG_RING_BUFFER_SIZE - 1 - ringUsed()) {
+    for (size_t i = 0; i < len; ++i) {
+      ring[ringHead] = line[i];
+      ringHead = (ringHead + 1) % LOG_RING_BUFFER_SIZE;
+    }
+  } else {
+    droppedLines++;
+  }
+  portEXIT_CRITICAL(&ringLock);
+}
+
+// Sends whatever fits into the UART TX FIFO without blocking
+static void ringDrain() {
+  for (;;) {
+    int room = Serial.availableForWrite();
+    if (room <= 0) {
+      return;
+    }
+    portENTER_CRITICAL(&ringLock);
+    size_t contiguous = ringHead >= ringTail ? ringHead - ringTail : LOG_RING_BUFFER_SIZE - ringTail;
+    size_t n = contiguous < (size_t)room ? contiguous : (size_t)room;
+    const char* chunk = ring + ringTail;
+    portEXIT_CRITICAL(&ringLock);
+    if (n == 0) {
+      return;
+    }
+    // only this task advances ringTail, so the chunk stays valid
+    Serial.write((const uint8_t*)chunk, n);
+    portENTER_CRITICAL(&ringLock);
+    ringTail = (ringTail + n) % LOG_RING_BUFFER_SIZE;
+    portEXIT_CRITICAL(&ringLock);
+  }
+}
+
+static void logTask(void*) {
+  uint32_t reported = 0;
+  for (;;) {
+    ringDrain();
+    if (droppedLines != reported) {
+      reported = droppedLines;
+      LOG_WARN("log: zahozeno %u radku", (unsigned)reported);
+    }
+    delay(20);
+  }
+}
+#endif
+
+void logBegin(unsigned long baud) {
+  Serial.begin(baud);
+#if LOG_RING_BUFFER
+  xTaskCreate(logTask, "log", 2048, nullptr, 0, nullptr);
+#endif
+}
+
+void logWrite(char level, const char* fmt, ...) {
+  char line[LINE_SIZE];
+  int len = snprintf(line, sizeof(line), "[%c] ", level);
+  va_list args;
+  va_start(args, fmt);
+  int body = vsnprintf(line + len, sizeof(line) - len - 2, fmt, args);
+  va_end(args);
+  len += body < 0 ? 0 : (body < (int)(sizeof(line) - len - 2) ? body : (int)(sizeof(line) - len - 3));
+  line[len++] = '\r';
+  line[len++] = '\n';
+#if LOG_RING_BUFFER
+  ringPush(line, len);
+#else
+  Serial.write((const uint8_t*)line, len);
+#endif
+}
+
+void logFlush() {
+#if LOG_RING_BUFFER
+  while (ringUsed() > 0) {
+    delay(5);
+  }
+#endif
+  Serial.flush();
+}
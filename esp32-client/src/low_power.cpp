@@ -0,0 +1,49 @@
+#include "low_power.h"
+
+#include <esp_sleep.h>
+#include "log.h"
+
+// Accumulated since power-on; RTC memory is kept through deep sleep
+RTC_DATA_ATTR static uint64_t rtcAwakeMs = 0;
+RTC_DATA_ATTR static uint64_t rtcSleepMs = 0;
+RTC_DATA_ATTR static uint32_t rtcWakeCount = 0;
+
+// start of the current awake period; boot (including a deep sleep wake-up)
+// starts at millis() == 0
+static unsigned long cycleStartMs = 0;
+
+bool lowPowerWokeFromDeepSleep() {
+  return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+}
+
+void lowPowerSleep(unsigned long intervalMs, int mode) {
+  unsigned long awakeMs = millis() - cycleStartMs;
+  unsigned long sleepMs = awakeMs < intervalMs ? intervalMs - awakeMs : 0;
+  rtcAwakeMs += awakeMs;
+  rtcSleepMs += sleepMs;
+  lowPowerReport();
+  if (sleepMs == 0) {
+    cycleStartMs = millis();
+    return;
+  }
+
+  esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+  rtcWakeCount++;
+  logFlush();
+  if (mode == LOW_POWER_DEEP) {
+    esp_deep_sleep_start();
+  }
+  esp_light_sleep_start();
+  cycleStartMs = millis();
+}
+
+void lowPowerReport() {
+  uint64_t totalMs = rtcAwakeMs + rtcSleepMs;
+  if (totalMs == 0) {
+    return;
+  }
+  float duty = (float)rtcAwakeMs / (float)totalMs;
+  float avgMa = duty * LOW_POWER_AWAKE_MA + (1.0f - duty) * LOW_POWER_SLEEP_MA;
+  LOG_INFO("Spanek: probuzeni %u, aktivni %.2f %%, prumerny odber (odhad) %.2f mA",
+           (unsigned)rtcWakeCount, duty * 100.0f, avgMa);
+}
@@ -3,9 +3,47 @@
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <ArduinoJson.h>
-#include <TM1637Display.h>
+#include "https_session.h"
+#include "glucose_stream.h"
+#include "low_power.h"
+#include "wifi_connect.h"
+#include "log.h"
+#include "glucose_history.h"
+#include "history_parser.h"
+#include "glucose_config.h"
+#include "glucose_alert.h"
+#include "glucose_frame.h"
+#include "display_view.h"
+#include "display_backend.h"
+#include "led_state.h"
+#include "led_engine.h"
+#include "latest_json.h"
+#include "compact_reading.h"
+#include "fetch_scheduler.h"
+#include "metrics.h"
+#include "local_server.h"
+#include "lan_push.h"
+#include "peer_link.h"
+#include "ota_update.h"
+#include "device_settings.h"
+#include "settings_store.h"
+#include "console.h"
+#include "provisioning.h"
+#include "reading_cache.h"
+#include "reading_store.h"
+#include "net_supervisor.h"
+#include "watchdog.h"
+#include "reading_trace.h"
+#include "trace_report.h"
+#include "device_id.h"
+#include <algorithm>
+#include <limits.h>
+#include <memory>
+#include <time.h>
+#include <sys/time.h>
+#include <driver/gpio.h>
 
-#define LED_PIN 15
+#define LED_PIN 15 // the board's own LED, mirrors the lit colour
 #define LED_RED 3
 #define LED_YELLOW 7
 #define LED_GREEN 5   
@@ -13,85 +51,688 @@
 // Seznam WiFi sítí (nahraďte názvy a hesla svými hodnotami)
 #include "secrets.h"
 
-TM1637Display display(35, 33);
+DisplayBackend glucoseDisplay; // GLUCOSE_DISPLAY, see display_backend.h
 
-struct WifiCred {
-  const char* ssid;
-  const char* pass;
-};
-
-WifiCred wifiCreds[] = {
+// Built-in defaults: networks saved over serial or the setup portal
+// (console.h, provisioning.h) take their place
+const WifiCred DEFAULT_WIFI[] = {
   { WIFI_SSID_1, WIFI_PASS_1 },
   { WIFI_SSID_2, WIFI_PASS_2 },
   // Přidejte další sítě podle potřeby (aktualizujte secrets.h a example)
 };
-const size_t WIFI_CREDS_COUNT = sizeof(wifiCreds) / sizeof(wifiCreds[0]);
+
+// WiFi list, RTDB url and push token; loadSettings() fills it before
+// anything else reads it
+DeviceSettings settings;
+WifiCred wifiCreds[SETTINGS_WIFI_MAX];
+size_t wifiCredsCount = 0;
+
+// Open the setup portal when no known network answers on a cold boot
+// within PROVISIONING_WAIT_S (not after a deep sleep wake-up: the router
+// is likely just down).
+// build_flags = -DGLUCOSE_PROVISIONING=0 keeps retrying instead.
+#ifndef GLUCOSE_PROVISIONING
+#define GLUCOSE_PROVISIONING 1
+#endif
 
 unsigned long loopCount = 0; // počítadlo průchodů loop()
 
-// Fetch interval and URL
-const char* GLUCOSE_URL = "https://gluco-watch-default-rtdb.europe-west1.firebasedatabase.app/users/78347/latest.json";
-const unsigned long FETCH_INTERVAL_MS = 1UL * 60UL * 1000UL; // 10 minutes
-unsigned long lastFetchMs = 0;
-void fetchGlucose();
-
-// Blink timing (milliseconds). Halved to make LEDs blink 2× faster.
-#define BLINK_DELAY 500
-
-// Helper: show glucose as clock HH:MM on the 4-digit display
-// - example: 3 -> 3:00, 3.51 -> 3:51
-void showGlucoseAsClock(float glucose) {
-  if (isnan(glucose) || glucose < 0.0f) {
-    // show 0:00 for invalid values
-    display.showNumberDecEx(0, 0b01000000, false, 4, 0);
+// RTDB user IDs to watch, as a list of string literals, e.g.
+// build_flags = '-DGLUCOSE_USERS="78347","12345"'. With more than one the
+// display cycles between them and the LEDs show the most urgent state.
+#ifndef GLUCOSE_USERS
+#define GLUCOSE_USERS "78347"
+#endif
+const char* const USER_IDS[] = { GLUCOSE_USERS };
+constexpr size_t USER_COUNT = sizeof(USER_IDS) / sizeof(USER_IDS[0]);
+// one digit on the "U  n" label; each user also keeps a 1.7 KB history
+static_assert(USER_COUNT <= 9, "GLUCOSE_USERS supports at most 9 users");
+// a display without cycling has a slot per user and nothing to blink in
+static_assert(DisplayBackend::CYCLES_USERS || USER_COUNT <= DisplayBackend::SLOTS,
+              "GLUCOSE_USERS has more users than the display has slots");
+static_assert(DisplayBackend::CYCLES_USERS || !DisplayBackend::BLINKS_STALE,
+              "only a display that cycles the users can blink a stale value");
+
+// Every node lives under users/<id>/ on this host (default of
+// settings.rtdbUrl)
+const char* DEFAULT_RTDB_URL = "https://gluco-watch-default-rtdb.europe-west1.firebasedatabase.app";
+const size_t URL_SIZE = 160;
+
+// Fetch interval and nodes
+const unsigned long FETCH_INTERVAL_MS = CONFIG.fetchIntervalMs; // 1 minute unless configured
+const char* GLUCOSE_NODE = "latest.json";
+void fetchGlucose(size_t user);
+
+// Compact mode: fetchGlucose() downloads the 8-byte record the ingestor
+// writes next to latest.json (18-byte body, see compact_reading.h) instead
+// of the JSON object, so polling needs no JSON parser. Enable with
+// build_flags = -DGLUCOSE_COMPACT=1; the event stream keeps using latest.json.
+#ifndef GLUCOSE_COMPACT
+#define GLUCOSE_COMPACT 0
+#endif
+#if GLUCOSE_COMPACT
+const char* GLUCOSE_FETCH_NODE = "compact.json";
+#else
+const char* GLUCOSE_FETCH_NODE = GLUCOSE_NODE;
+#endif
+
+// History written by the ingestor next to latest.json, newest
+// GlucoseHistory::CAPACITY (288) entries: {"<unix_ts>": <mmol/L>, ...}
+const char* GLUCOSE_HISTORY_NODE = "history.json?orderBy=%22%24key%22&limitToLast=288";
+// Backfill again when WiFi comes back after an outage this long
+const unsigned long BACKFILL_AFTER_OUTAGE_MS = 10UL * 60UL * 1000UL;
+// Reconnect backoff, WiFi restart and reboot when nothing gets through
+// (see superviseNetwork())
+NetSupervisor netSupervisor;
+void backfillHistory(size_t user);
+
+// RTDB REST URL of a node under users/<id>/
+void userUrl(char* url, size_t user, const char* node) {
+  snprintf(url, URL_SIZE, "%s/users/%s/%s", settings.rtdbUrl, USER_IDS[user], node);
+}
+
+// Per-user state kept in RTC memory, so a deep sleep wake-up can restore
+// the LEDs, keeps the learned cadence and still sends If-None-Match.
+// Polls are timed to just after the next reading is expected (see
+// fetch_scheduler.h); FETCH_INTERVAL_MS is the longest gap between polls
+// while no new reading shows up.
+struct UserRtc {
+  uint16_t shownMgdl = GLUCOSE_NONE; // last value on the display
+  FetchScheduler scheduler{ CONFIG.fetchIntervalMs };
+  // ETag of the last processed latest.json. RTDB returns it when asked
+  // with "X-Firebase-ETag: true"; an unchanged ETag means the CGM has
+  // not published a new reading yet.
+  char etag[48] = "";
+};
+RTC_DATA_ATTR UserRtc userRtc[USER_COUNT];
+
+// Newest readings of each user in RTC memory that the boot leaves alone,
+// so after a watchdog or panic reset (and a deep sleep wake-up) the
+// display is painted before WiFi is up; the NVS copy (reading_store.h)
+// covers power loss. See restoreReadings().
+RTC_NOINIT_ATTR ReadingCache rtcReadings[USER_COUNT];
+RTC_DATA_ATTR uint32_t storedReadingAt[USER_COUNT]; // newest reading in NVS
+
+struct UserState {
+  GlucoseHistory history; // last 24 h, source of the trend arrow and the alarm
+  Trend shownTrend = Trend::Unknown;
+  AlertStatus alert{ false, false, false, 0 };
+  unsigned long lastFetchMs = 0;
+  unsigned long fetchDelayMs = FETCH_INTERVAL_MS; // from lastFetchMs to the next poll
+  char tag[12] = ""; // "<id>: " in log lines when watching several users
+  // newest reading's trace, open until the display has shown it
+  ReadingTrace trace;
+  unsigned long traceStartMs = 0;
+  bool tracing = false;
+};
+UserState users[USER_COUNT];
+
+// Shared keep-alive TLS connection to the RTDB host (avoids a full
+// handshake on every fetch)
+HttpsSession glucoseSession;
+
+// Battery mode: sleep between fetches (LOW_POWER_LIGHT or LOW_POWER_DEEP,
+// see low_power.h). With LOW_POWER_BLANK_DISPLAY 1 the display and LEDs
+// are switched off while sleeping, otherwise they keep the last value
+// (e-paper keeps it either way, at no cost).
+#ifndef LOW_POWER_MODE
+#define LOW_POWER_MODE LOW_POWER_OFF
+#endif
+#ifndef LOW_POWER_BLANK_DISPLAY
+#define LOW_POWER_BLANK_DISPLAY 0
+#endif
+
+// Latency of each user's last TRACE_WINDOW readings (reading_trace.h).
+// About 1 KB per user, so only deep sleep builds keep them in RTC memory,
+// to still gather a window across wake-ups.
+#if LOW_POWER_MODE == LOW_POWER_DEEP
+#define TRACE_ATTR RTC_DATA_ATTR
+#else
+#define TRACE_ATTR
+#endif
+TRACE_ATTR TraceWindow traceWindows[USER_COUNT];
+TRACE_ATTR uint32_t traceReportedAt = 0; // unix s of the last report
+
+// The S2 has 8 KB of RTC slow memory; leave room for the core's and the
+// other modules' RTC variables
+const size_t RTC_BUDGET = 7 * 1024;
+static_assert(sizeof(userRtc) + sizeof(rtcReadings) + sizeof(storedReadingAt)
+                  + (LOW_POWER_MODE == LOW_POWER_DEEP ? sizeof(traceWindows) : 0) <= RTC_BUDGET,
+              "RTC memory overflow: lower TRACE_WINDOW (e.g. -DTRACE_WINDOW=16) or GLUCOSE_USERS");
+
+// LAN push: the ingestor POSTs each reading straight to the device (see
+// lan_push.h; the token is settings.pushToken, by default PUSH_TOKEN of
+// secrets.h) and the cloud is only polled when pushes stop arriving.
+// Enable with -DGLUCOSE_LAN_PUSH=1 and set LAN_PUSH_URLS in the
+// ingestor's .env.
+#ifndef GLUCOSE_LAN_PUSH
+#define GLUCOSE_LAN_PUSH 0
+#endif
+
+// Peer mode: displays on one LAN share readings over UDP multicast (see
+// peer_link.h). The elected leader polls the cloud and multicasts each
+// new reading; the others poll PEER_FOLLOWER_LAG_MS later, which the
+// leader's reading normally makes unnecessary, so N displays cost one
+// cloud fetch and all of them change at the same moment. Enable with
+// -DGLUCOSE_PEER=1 on every display; the packets are signed with
+// settings.pushToken, which must be the same on all of them.
+#ifndef GLUCOSE_PEER
+#define GLUCOSE_PEER 0
+#endif
+const unsigned long PEER_FOLLOWER_LAG_MS = 20UL * 1000UL;
+
+// OTA: every OTA_CHECK_INTERVAL_H hours the device reads
+// firmware/<OTA_CHANNEL>.json from RTDB (see ota_manifest.h) and installs
+// a newer FIRMWARE_VERSION from the URL in it; the image host must chain
+// up to the roots in rtdb_trust.h (Firebase/Cloud Storage do). Publish
+// with tools/make_ota_image.py. Enable with -DGLUCOSE_OTA=1.
+#ifndef GLUCOSE_OTA
+#define GLUCOSE_OTA 0
+#endif
+#ifndef OTA_CHANNEL
+#define OTA_CHANNEL "lolin_s2_mini"
+#endif
+
+// Streaming mode: keep an RTDB event stream open on latest.json and update
+// as soon as the ingestor writes a new reading. Set to 0 (e.g. via
+// build_flags = -DGLUCOSE_STREAMING=0) to fall back to periodic polling.
+// Not available in battery mode, which needs the radio off between fetches.
+// A stream holds its connection, so with several users they are polled
+// over the one shared keep-alive connection instead (a stream on the
+// parent users node would deliver every person's full history). Off by
+// default with LAN push and peer mode, whose cloud fallback needs no
+// open connection.
+#ifndef GLUCOSE_STREAMING
+#define GLUCOSE_STREAMING (LOW_POWER_MODE == LOW_POWER_OFF && !GLUCOSE_LAN_PUSH && !GLUCOSE_PEER)
+#endif
+#if GLUCOSE_STREAMING && LOW_POWER_MODE != LOW_POWER_OFF
+#error "GLUCOSE_STREAMING cannot be combined with LOW_POWER_MODE"
+#endif
+// Port of the local HTTP server (GET /metrics, see metrics.h, and POST
+// /push), 0 = off. Off in battery mode, where the device sleeps between
+// fetches. METRICS_HTTP_PORT is the older name of the same setting.
+#if !defined(LOCAL_HTTP_PORT) && defined(METRICS_HTTP_PORT)
+#define LOCAL_HTTP_PORT METRICS_HTTP_PORT
+#endif
+#ifndef LOCAL_HTTP_PORT
+#define LOCAL_HTTP_PORT (LOW_POWER_MODE == LOW_POWER_OFF ? 80 : 0)
+#endif
+#if GLUCOSE_LAN_PUSH && (LOW_POWER_MODE != LOW_POWER_OFF || LOCAL_HTTP_PORT == 0)
+#error "GLUCOSE_LAN_PUSH needs the local HTTP server and no LOW_POWER_MODE"
+#endif
+#if GLUCOSE_PEER && LOW_POWER_MODE != LOW_POWER_OFF
+#error "GLUCOSE_PEER cannot be combined with LOW_POWER_MODE"
+#endif
+// After a reading from the LAN (push or peer) the user's cloud poll waits
+// for the next reading plus this long, so it only happens if the next
+// one doesn't arrive the same way
+const unsigned long LAN_GRACE_MS = 60UL * 1000UL;
+bool onPush(const char* uid, const GlucoseReading& reading);
+bool onPeerReading(const char* uid, const GlucoseReading& reading, uint32_t publishedAt);
+
+const bool STREAMING = GLUCOSE_STREAMING && USER_COUNT == 1;
+const unsigned long STREAM_RETRY_MS = 10UL * 1000UL; // pause between reconnect attempts
+unsigned long lastStreamOpenMs = 0;
+char streamUrl[URL_SIZE]; // set in setup()
+GlucoseStream glucoseStream(glucoseSession, streamUrl);
+void onGlucose(size_t user, const GlucoseReading& reading, uint32_t publishedAt, TraceSource source);
+
+// POSIX TZ rule of the local time the LEDs dim by (CONFIG.nightFromH and
+// nightToH); the default is Central European time with its DST switch
+#ifndef GLUCOSE_TZ
+#define GLUCOSE_TZ "CET-1CEST,M3.5.0,M10.5.0/3"
+#endif
+
+// Unix time from SNTP (configTzTime() in setup()); 0 until it is synced
+uint32_t unixNow() {
+  time_t now = time(nullptr);
+  return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+// Same in ms, for the reading traces
+uint64_t unixNowMs() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return now.tv_sec > 1600000000 ? (uint64_t)now.tv_sec * 1000 + now.tv_usec / 1000 : 0;
+}
+
+// Threshold colour of the most urgent value on the display, steady
+LedState thresholdLeds() {
+  LedState worst{ LedColor::Off, 0, false };
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    worst = worseLedState(worst, LedState{ ledColorFor(userRtc[u].shownMgdl), 0, false });
+  }
+  return worst;
+}
+
+// Plain GPIO levels, for the wake-up from deep sleep before the LED
+// engine takes the pins over
+void applyLeds(LedColor color) {
+  digitalWrite(LED_RED, color == LedColor::Red ? HIGH : LOW);
+  digitalWrite(LED_YELLOW, color == LedColor::Yellow ? HIGH : LOW);
+  digitalWrite(LED_GREEN, color == LedColor::Green ? HIGH : LOW);
+  digitalWrite(LED_PIN, color != LedColor::Off ? HIGH : LOW);
+}
+
+// Deep sleep powers down the GPIO matrix; holding the pads keeps the LEDs
+// at their current level until the next wake-up
+void holdLeds() {
+  gpio_hold_en((gpio_num_t)LED_RED);
+  gpio_hold_en((gpio_num_t)LED_YELLOW);
+  gpio_hold_en((gpio_num_t)LED_GREEN);
+  gpio_hold_en((gpio_num_t)LED_PIN);
+  gpio_deep_sleep_hold_en();
+}
+
+void releaseLedHold() {
+  gpio_hold_dis((gpio_num_t)LED_RED);
+  gpio_hold_dis((gpio_num_t)LED_YELLOW);
+  gpio_hold_dis((gpio_num_t)LED_GREEN);
+  gpio_hold_dis((gpio_num_t)LED_PIN);
+}
+
+// The display is driven from its own FreeRTOS task, so a slow or hanging
+// HTTPS request in loop() (the network task) can never hold it back. The
+// task waits on a single-slot mailbox that always holds the newest value.
+// The LEDs need no task: their patterns run in led_engine.h.
+QueueHandle_t displayMailbox;
+SemaphoreHandle_t displayLock; // held by the display task while it draws
+
+// One view per user; the display task cycles through them, or shows
+// them side by side on a backend with a slot for each. A stale one
+// (restored after a reset, no reading since) blinks, or is marked on
+// backends that can't blink.
+struct DisplaySet {
+  DisplayView views[USER_COUNT];
+  uint32_t seq[USER_COUNT]; // traced readings of each user so far
+};
+DisplaySet displaySet; // network task's copy, posted whole
+const unsigned long DISPLAY_LABEL_MS = 800; // "U  n" before each user's value
+const unsigned long DISPLAY_STALE_BLINK_MS = 500;
+
+// When the display task first showed each user's seq, for the traces
+struct ShownStamp {
+  uint32_t seq;
+  unsigned long atMs;
+};
+ShownStamp shownStamps[USER_COUNT];
+portMUX_TYPE shownMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Draws u's view and stamps a traced reading the first time it is out
+void showView(const DisplaySet& set, size_t u) {
+  glucoseDisplay.show(set.views[u], DisplayBackend::CYCLES_USERS ? 0 : (uint8_t)u);
+  portENTER_CRITICAL(&shownMux);
+  if (shownStamps[u].seq != set.seq[u]) {
+    shownStamps[u].seq = set.seq[u];
+    shownStamps[u].atMs = millis();
+  }
+  portEXIT_CRITICAL(&shownMux);
+}
+
+// With several users the mailbox wait doubles as the cycle timer:
+// label, value for CONFIG.cycleMs, next user's label, ... A stale value
+// splits its part of the cycle into blink steps. A backend with a slot
+// per user only draws what a post changed.
+void displayTask(void*) {
+  DisplaySet set;
+  if (!DisplayBackend::CYCLES_USERS) {
+    for (;;) {
+      xQueueReceive(displayMailbox, &set, portMAX_DELAY);
+      xSemaphoreTake(displayLock, portMAX_DELAY);
+      for (size_t u = 0; u < USER_COUNT; ++u) {
+        showView(set, u);
+      }
+      xSemaphoreGive(displayLock);
+    }
+  }
+  bool received = false;
+  size_t current = 0;
+  bool label = false;
+  bool dark = false;        // off half of a stale value's blink
+  TickType_t phaseLeft = 0; // of the label or value, while cycling
+  for (;;) {
+    bool cycling = USER_COUNT > 1 && received;
+    bool blinking = DisplayBackend::BLINKS_STALE && received && !label && set.views[current].stale;
+    TickType_t wait = cycling ? phaseLeft : portMAX_DELAY;
+    if (blinking) {
+      wait = std::min(wait, (TickType_t)pdMS_TO_TICKS(DISPLAY_STALE_BLINK_MS));
+    }
+    bool posted = xQueueReceive(displayMailbox, &set, wait) == pdTRUE;
+    xSemaphoreTake(displayLock, portMAX_DELAY);
+    if (posted) {
+      received = true;
+      phaseLeft = pdMS_TO_TICKS(label ? DISPLAY_LABEL_MS : CONFIG.cycleMs);
+      if (!label) {
+        dark = false;
+        showView(set, current);
+      }
+    } else if (blinking && (!cycling || wait < phaseLeft)) {
+      phaseLeft -= cycling ? wait : 0;
+      dark = !dark;
+      if (dark) {
+        glucoseDisplay.blank();
+      } else {
+        showView(set, current);
+      }
+    } else if (label) {
+      label = false;
+      dark = false;
+      phaseLeft = pdMS_TO_TICKS(CONFIG.cycleMs);
+      showView(set, current);
+    } else {
+      current = (current + 1) % USER_COUNT;
+      label = true;
+      phaseLeft = pdMS_TO_TICKS(DISPLAY_LABEL_MS);
+      glucoseDisplay.label((uint8_t)(current + 1));
+    }
+    xSemaphoreGive(displayLock);
+  }
+}
+
+void startRenderTasks() {
+  displayMailbox = xQueueCreate(1, sizeof(DisplaySet));
+  displayLock = xSemaphoreCreateMutex();
+  // loop() runs at priority 1
+  xTaskCreate(displayTask, "display", DisplayBackend::TASK_STACK, nullptr, 2, nullptr);
+}
+
+// Blocks the caller until the display task has drawn the posted views
+void waitForRender() {
+  while (uxQueueMessagesWaiting(displayMailbox) > 0) {
+    delay(1);
+  }
+  // the task outranks loop(), so it holds the lock from taking the views
+  // until the draw is out (an e-paper refresh takes about a second)
+  xSemaphoreTake(displayLock, portMAX_DELAY);
+  xSemaphoreGive(displayLock);
+}
+
+// Re-evaluates the local alarm of every user and shows the most urgent
+// LED state when it changed (force: show anyway, e.g. after the LEDs were
+// blanked). Called for every reading and on every loop() pass, so
+// prediction and stale detection keep running while the network is down.
+void updateLeds(bool force = false) {
+  static LedState posted{ LedColor::Off, 0, false };
+  uint32_t now = unixNow();
+  LedState worst{ LedColor::Off, 0, false };
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    UserState& user = users[u];
+    AlertStatus alert = evaluateAlert(user.history, now);
+    if (alert.predictedLow != user.alert.predictedLow) {
+      if (alert.predictedLow) {
+        LOG_WARN("%sPredikce: za %d min %ld mg/dL (pod %d)", user.tag, ALERT_HORIZON_MIN,
+                 (long)alert.predictedMgdl, (int)CONFIG.lowMgdl);
+      } else {
+        LOG_INFO("%sPredikce: hypoglykemie uz nehrozi", user.tag);
+      }
+    }
+    if (alert.stale != user.alert.stale) {
+      if (alert.stale) {
+        LOG_WARN("%sData jsou starsi nez %d min", user.tag, ALERT_STALE_AFTER_S / 60);
+      } else {
+        LOG_INFO("%sData jsou opet aktualni", user.tag);
+      }
+    }
+    user.alert = alert;
+    // a value restored after a reset is not vouched for until a reading
+    // arrives, even while the clock can't tell its age
+    AlertStatus shown = alert;
+    shown.stale = shown.stale || displaySet.views[u].stale;
+    worst = worseLedState(worst, ledStateFor(userRtc[u].shownMgdl, shown));
+  }
+
+  if (!force && worst == posted) {
     return;
   }
+  if (worst != posted) {
+    LOG_DEBUG("LED: %s%s", worst.color == LedColor::Red ? "cervena" : worst.color == LedColor::Yellow ? "zluta"
+                           : worst.color == LedColor::Green ? "zelena" : "zhasnuto",
+              worst.blinkMs == 0 ? "" : worst.fade ? " (pulzuje)" : " (blika)");
+  }
+  posted = worst;
+  ledEngineShow(worst);
+}
+
+// Local hour for the night dimming, -1 until SNTP has synced
+int localHour() {
+  if (unixNow() == 0) {
+    return -1;
+  }
+  time_t now = time(nullptr);
+  struct tm local;
+  localtime_r(&now, &local);
+  return local.tm_hour;
+}
+
+// Rebuilds u's view from what is shown for them, keeping the stale flag;
+// the sparkline only for backends that draw one
+void setView(size_t u, uint16_t mgdl, Trend trend) {
+  DisplayView& view = displaySet.views[u];
+  view = displayView(mgdl, trend, view.stale);
+  if (DisplayBackend::SPARKLINE) {
+    sparklineFrom(users[u].history, view.spark);
+  }
+}
+
+// Update display and LEDs for a user's new glucose value (does not block)
+void updateLedForGlucose(size_t user, uint16_t mgdl, Trend trend) {
+  LOG_DEBUG("%sAktualizuji LEDy podle cukru: %u mg/dL", users[user].tag, mgdl);
+
+  setView(user, mgdl, trend);
+  xQueueOverwrite(displayMailbox, &displaySet);
+  updateLeds(true);
+}
+
+// Re-posts what the display and LEDs showed before they were blanked
+void restoreDisplay() {
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    setView(u, userRtc[u].shownMgdl, users[u].shownTrend);
+  }
+  xQueueOverwrite(displayMailbox, &displaySet);
+  updateLeds(true);
+}
+
+// Every user during one wake-up in battery mode, due ones when polling
+void fetchAllUsers() {
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    fetchGlucose(u);
+    users[u].lastFetchMs = millis();
+  }
+}
+
+void fetchDueUsers() {
+  // followers give the leader a head start (see GLUCOSE_PEER)
+  unsigned long lagMs = GLUCOSE_PEER && !peerIsLeader() ? PEER_FOLLOWER_LAG_MS : 0;
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    unsigned long now = millis();
+    if (now - users[u].lastFetchMs >= users[u].fetchDelayMs + lagMs) {
+      fetchGlucose(u);
+      users[u].lastFetchMs = now;
+    }
+  }
+}
 
-  int hours = (int)floor(glucose);
-  float frac = glucose - (float)hours;
-  int minutes = (int)round(frac * 100.0f);
-  if (minutes >= 100) { // carry if rounding pushed minutes to 100
-    minutes = 0;
-    hours += 1;
+// Shortest poll delay over all users, from the last fetchAllUsers()
+unsigned long nextFetchDelayMs() {
+  unsigned long delayMs = ULONG_MAX;
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    delayMs = std::min(delayMs, users[u].fetchDelayMs);
   }
+  return delayMs;
+}
+
+// Files u's open trace; displayMs TRACE_NONE if it never made it out
+void traceClose(size_t u, uint32_t displayMs) {
+  UserState& user = users[u];
+  user.trace.displayMs = displayMs;
+  traceWindows[u].add(user.trace);
+  user.tracing = false;
+}
 
-  if (hours > 99) {
-    // cannot display more than 2-digit hours on 4-digit display; show 9999 as overflow
-    display.showNumberDec(9999, true, 4, 0);
+// Files the traces whose reading the display task has shown by now
+void fileTraces() {
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    if (!users[u].tracing) {
+      continue;
+    }
+    portENTER_CRITICAL(&shownMux);
+    ShownStamp stamp = shownStamps[u];
+    portEXIT_CRITICAL(&shownMux);
+    if (stamp.seq == displaySet.seq[u]) {
+      traceClose(u, (uint32_t)(stamp.atMs - users[u].traceStartMs));
+    }
+  }
+}
+
+// Starts the trace of u's new reading. Needs SNTP: the sensor time is
+// only comparable with the wall clock.
+void traceOpen(size_t u, const GlucoseReading& reading, uint32_t publishedAt, TraceSource source) {
+  UserState& user = users[u];
+  fileTraces();
+  if (user.tracing) {
+    traceClose(u, TRACE_NONE); // replaced before its turn on the display
+  }
+  uint64_t nowMs = unixNowMs();
+  if (nowMs == 0) {
     return;
   }
+  user.trace = ReadingTrace{ reading.timestamp, publishedAt, nowMs, TRACE_NONE, source };
+  user.traceStartMs = millis();
+  user.tracing = true;
+  displaySet.seq[u]++;
+}
+
+// Logs the latency percentiles every TRACE_REPORT_MIN, and with
+// TRACE_POST stores them in RTDB
+void reportTraces() {
+  fileTraces();
+  uint32_t now = unixNow();
+  if (TRACE_REPORT_MIN == 0 || now == 0) {
+    return;
+  }
+  if (traceReportedAt == 0) {
+    traceReportedAt = now; // the first period starts with the clock
+    return;
+  }
+  if (now - traceReportedAt < TRACE_REPORT_MIN * 60UL) {
+    return;
+  }
+  traceReportedAt = now;
+  traceLog();
+#if TRACE_POST
+  if (WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  if (STREAMING && glucoseStream.connected()) {
+    // the event stream holds glucoseSession's socket; like the OTA check,
+    // close it for the PUT, it reopens on its own with the current value
+    glucoseStream.close();
+    glucoseSession.reset();
+  }
+  char node[48];
+  snprintf(node, sizeof(node), "latency/%s.json", deviceName());
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    char url[URL_SIZE];
+    userUrl(url, u, node);
+    tracePost(glucoseSession, url, u, now);
+  }
+#endif
+}
+
+#if LOW_POWER_MODE != LOW_POWER_OFF
+// Sleep until the next fetch is due; deep sleep continues in setup()
+void sleepUntilNextFetch() {
+  waitForRender();
+  fileTraces(); // what is still open is not in RTC memory
+#if LOW_POWER_BLANK_DISPLAY
+  glucoseDisplay.setPower(false);
+  ledEngineShow(LedState{ LedColor::Off, 0, false });
+#endif
+  ledEngineSuspend(); // a blink or a dimmed colour can't run through sleep
+  if (LOW_POWER_MODE == LOW_POWER_DEEP) {
+    glucoseSession.reset();
+    holdLeds();
+  }
+  // every user is fetched on each wake-up (unchanged ones cost a 304 over
+  // the shared connection), so sleep until the first one is due
+  lowPowerSleep(nextFetchDelayMs(), LOW_POWER_MODE);
+
+  // light sleep returns here
+  watchdogFeed();
+  ledEngineResume();
+#if LOW_POWER_BLANK_DISPLAY
+  glucoseDisplay.setPower(true);
+  restoreDisplay();
+#endif
+  if (WiFi.status() != WL_CONNECTED) {
+    WiFi.reconnect();
+    waitForWifi(5000);
+  }
+}
+#endif
 
-  int val = hours * 100 + minutes; // e.g., 3:51 -> 351
-  // Use dot/colon bit (0b01000000) to render colon between 2nd and 3rd digits
-  display.showNumberDecEx(val, 0b01000000, false, 4, 0);
-}
-
-// Update LEDs based on glucose value:
-// - red if glucose < 3.9
-// - yellow if glucose > 10
-// - green otherwise
-void updateLedForGlucose(float glucose) {
-  Serial.print("Aktualizuji LEDy podle cukru: ");
-  Serial.println(glucose);
-
-  // show as HH:MM on 4-digit display
-  showGlucoseAsClock(glucose);
-
-  if (glucose < 3.9f) {
-    digitalWrite(LED_RED, HIGH);
-    digitalWrite(LED_YELLOW, LOW);
-    digitalWrite(LED_GREEN, LOW);
-    Serial.println("Rozsvitena cervena LED");
-  } else if (glucose > 10.0f) {
-    digitalWrite(LED_RED, LOW);
-    digitalWrite(LED_YELLOW, HIGH);
-    digitalWrite(LED_GREEN, LOW);
-    Serial.println("Rozsvitena zluta LED");
+// Copies u's newest readings to RTC memory, and to NVS once the copy there
+// is READING_STORE_INTERVAL_MIN behind
+void cacheReadings(size_t u) {
+  uint32_t owner = readingCacheOwner(USER_IDS[u]);
+  readingCacheStore(rtcReadings[u], owner, users[u].history);
+  uint32_t newest = readingCacheNewest(rtcReadings[u], owner);
+  if (newest == 0 || newest - storedReadingAt[u] < READING_STORE_INTERVAL_MIN * 60UL) {
+    return;
+  }
+  if (readingStoreSave(u, rtcReadings[u])) {
+    storedReadingAt[u] = newest;
   } else {
-    digitalWrite(LED_RED, LOW);
-    digitalWrite(LED_YELLOW, LOW);
-    digitalWrite(LED_GREEN, HIGH);
-    Serial.println("Rozsvitena zelena LED");
+    LOG_WARN("%sUlozeni poslednich hodnot do NVS selhalo", users[u].tag);
+  }
+}
+
+// Brings back each user's newest readings from RTC memory, or from NVS
+// after power loss, before anything waits on the network. After a reset
+// the values are shown as stale until a reading confirms them; after a
+// deep sleep wake-up they are current. True if there is something to paint.
+bool restoreReadings() {
+  bool woke = lowPowerWokeFromDeepSleep();
+  bool any = false;
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    UserState& user = users[u];
+    uint32_t owner = readingCacheOwner(USER_IDS[u]);
+    bool restored = readingCacheRestore(rtcReadings[u], owner, user.history);
+    if (!restored && !woke) {
+      ReadingCache stored;
+      restored = readingStoreLoad(u, stored) && readingCacheRestore(stored, owner, user.history);
+      if (restored) {
+        rtcReadings[u] = stored;
+        storedReadingAt[u] = readingCacheNewest(stored, owner);
+      }
+    }
+    if (!restored) {
+      continue;
+    }
+    user.shownTrend = user.history.trend();
+    if (!woke) {
+      userRtc[u].shownMgdl = user.history.latest().mgdl;
+      displaySet.views[u].stale = true;
+      any = true;
+    }
+  }
+  return any;
+}
+
+// The built-in defaults, overridden by whatever was saved to NVS
+void loadSettings() {
+  settingsClear(settings);
+  for (const WifiCred& cred : DEFAULT_WIFI) {
+    settingsAddWifi(settings, cred.ssid, cred.pass);
+  }
+  settingsSetUrl(settings, DEFAULT_RTDB_URL);
+  settingsSetToken(settings, PUSH_TOKEN);
+  if (settingsLoad(settings)) {
+    LOG_INFO("Nastaveni nacteno z NVS (%u WiFi siti)", (unsigned)settings.wifiCount);
+  }
+  wifiCredsCount = settings.wifiCount;
+  for (size_t i = 0; i < wifiCredsCount; ++i) {
+    wifiCreds[i] = { settings.wifi[i].ssid, settings.wifi[i].pass };
   }
 }
 
@@ -101,137 +742,537 @@ void setup()
   pinMode(LED_RED, OUTPUT);
   pinMode(LED_YELLOW, OUTPUT);
   pinMode(LED_GREEN, OUTPUT);
+  if (lowPowerWokeFromDeepSleep()) {
+    // LEDs were held at their level during deep sleep; drive the same
+    // level before releasing the pads so they don't flicker
+    applyLeds(thresholdLeds().color);
+    releaseLedHold();
+  }
 
-  Serial.begin(115200); // inicializace sériové linky
+  logBegin(115200); // inicializace sériové linky
+  watchdogBegin(); // setup() already runs on the network task
   // while (!Serial) {            // počká na otevření Serial Monitoru (u ESP32 není nutné, ale nevadí)
   //   delay(10);
   // }
 
-  display.setBrightness(0x0f);
+  glucoseDisplay.begin(lowPowerWokeFromDeepSleep(), USER_COUNT);
+#if LOW_POWER_BLANK_DISPLAY
+  // a display that kept its image through the sleep still shows it
+  if (!DisplayBackend::KEEPS_IMAGE && lowPowerWokeFromDeepSleep() && userRtc[0].shownMgdl != GLUCOSE_NONE) {
+    glucoseDisplay.show(displayView(userRtc[0].shownMgdl, Trend::Unknown, false));
+  }
+#endif
+  // the last readings go up before WiFi and TLS, blinking until confirmed
+  bool restored = restoreReadings();
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    setView(u, userRtc[u].shownMgdl, users[u].shownTrend);
+  }
+  startRenderTasks();
+  if (restored) {
+    xQueueOverwrite(displayMailbox, &displaySet);
+  }
+  ledEngineBegin(LED_RED, LED_YELLOW, LED_GREEN, LED_PIN);
+  updateLeds(true); // the restored state, or what the pads were held at
 
-  Serial.println("ESP32 startuje...");
+  LOG_INFO("ESP32 startuje... (firmware %u)", (unsigned)FIRMWARE_VERSION);
+  loadSettings();
+  consoleBegin(settings);
+  traceBegin(USER_IDS, traceWindows, USER_COUNT);
+#if GLUCOSE_OTA
+  otaBegin(); // may roll a failed update back
+#endif
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    if (USER_COUNT > 1) {
+      snprintf(users[u].tag, sizeof(users[u].tag), "%s: ", USER_IDS[u]);
+    }
+  }
+  if (USER_COUNT > 1) {
+    LOG_INFO("Sleduji %u uzivatelu pres jedno spojeni%s", (unsigned)USER_COUNT,
+             GLUCOSE_STREAMING ? " (bez streamu)" : "");
+  }
+  userUrl(streamUrl, 0, GLUCOSE_NODE);
 
-  // Připojení k WiFi (zkusíme více sítí, jednu po druhé)
-  WiFi.mode(WIFI_STA);
+  // Připojení k WiFi (nejdriv naposledy pouzity AP z NVS, pak sken)
+  bool connected = wifiConnect(wifiCreds, wifiCredsCount);
+#if GLUCOSE_PROVISIONING
+  // the setup network only once the known networks had time to come up
+  unsigned long waitStart = millis();
+  while (!connected && wifiCredsCount > 0 && !lowPowerWokeFromDeepSleep()
+         && millis() - waitStart < PROVISIONING_WAIT_S * 1000UL) {
+    LOG_INFO("WiFi nedostupna, zkusim znovu pred spustenim nastaveni");
+    watchdogFeed();
+    delay(10000);
+    connected = wifiConnect(wifiCreds, wifiCredsCount);
+  }
+#endif
+  if (LOCAL_HTTP_PORT != 0) {
+    WebServer& server = localServerBegin(LOCAL_HTTP_PORT);
+    metricsRoutes(server);
+#if GLUCOSE_LAN_PUSH
+    lanPushRoutes(server, settings.pushToken, onPush);
+#endif
+  }
+#if GLUCOSE_PEER
+  peerBegin(onPeerReading, settings.pushToken); // joins the group once WiFi is up
+#endif
+  // SNTP syncs in the background once the network is up; the clock is
+  // needed for the stale-data check and, in local time, the night dimming
+  configTzTime(GLUCOSE_TZ, "pool.ntp.org", "time.google.com");
 
-  const unsigned long perNetworkTimeout = 8000; // ms na jednu síť
-  bool connected = false;
-  for (size_t i = 0; i < WIFI_CREDS_COUNT; ++i) {
-    const char* trySsid = wifiCreds[i].ssid;
-    const char* tryPass = wifiCreds[i].pass;
+  if (!connected) {
+    LOG_ERROR("Nebyla nalezena zadna dostupna WiFi (vsechny pokusy selhaly).");
+#if GLUCOSE_PROVISIONING
+    if (!lowPowerWokeFromDeepSleep()) {
+      provisioningRun(settings); // restarts when saved or timed out
+    }
+#endif
+  } else {
+    WifiLinkChange first;
+    wifiTakeLinkChange(first); // fetched below anyway, not a reconnect
+    if (!lowPowerWokeFromDeepSleep()) {
+      for (size_t u = 0; u < USER_COUNT; ++u) {
+        backfillHistory(u);
+      }
+    }
+    if (STREAMING) {
+      // the stream's first 'put' event carries the current value
+      glucoseStream.open();
+      lastStreamOpenMs = millis();
+    } else {
+      // initial fetch immediately after successful WiFi connection
+      fetchAllUsers();
+    }
+  }
+}
 
-    Serial.print("Zkousim WiFi '");
-    Serial.print(trySsid);
-    Serial.print("'...");
+// Record the reading and redraw only when value or trend changed.
+// publishedAt and source only go into the reading's trace.
+void onGlucose(size_t u, const GlucoseReading& reading, uint32_t publishedAt, TraceSource source) {
+  UserState& user = users[u];
+#if GLUCOSE_OTA
+  otaConfirm(); // a reading: a freshly installed image works
+#endif
+  uint16_t tenths = mgdlToTenths(reading.mgdl);
+  LOG_INFO("%sHladina cukru: %u.%u (%u mg/dL)", user.tag, tenths / 10, tenths % 10, reading.mgdl);
+  if (reading.timestamp != 0 && user.history.add(reading.timestamp, reading.mgdl)) {
+    LOG_DEBUG("%sTrend: %.2f mg/dL/min", user.tag, user.history.slope());
+    cacheReadings(u);
+    traceOpen(u, reading, publishedAt, source);
+  }
+  Trend trend = user.history.trend();
+  bool confirmed = displaySet.views[u].stale; // a restored value, now current
+  displaySet.views[u].stale = false;
+  if (!confirmed && reading.mgdl == userRtc[u].shownMgdl && trend == user.shownTrend) {
+    if (user.tracing) {
+      traceClose(u, 0); // already on the display
+    }
+    return;
+  }
+  userRtc[u].shownMgdl = reading.mgdl;
+  user.shownTrend = trend;
+  updateLedForGlucose(u, reading.mgdl, trend);
+}
 
-    WiFi.begin(trySsid, tryPass);
+// Hands a reading this device got from the cloud or a push to the other
+// displays (peer mode); readings from peers are not passed on again
+void shareReading(size_t u, const GlucoseReading& reading, uint32_t publishedAt) {
+#if GLUCOSE_PEER
+  peerBroadcast(USER_IDS[u], reading, publishedAt);
+#endif
+}
 
-    unsigned long startAttempt = millis();
-    while (WiFi.status() != WL_CONNECTED && (millis() - startAttempt) < perNetworkTimeout) {
-      delay(500);
-      Serial.print('.');
+// Index of uid in GLUCOSE_USERS, -1 if this display doesn't watch it
+int userIndex(const char* uid) {
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    if (strcmp(USER_IDS[u], uid) == 0) {
+      return (int)u;
     }
-    Serial.println();
+  }
+  return -1;
+}
 
-    if (WiFi.status() == WL_CONNECTED) {
-      Serial.print("WiFi pripojeno ('");
-      Serial.print(trySsid);
-      Serial.print("'), IP: ");
-      Serial.println(WiFi.localIP());
-      connected = true;
-      break;
-    } else {
-      Serial.print("Nepodarilo se pripojit k '");
-      Serial.print(trySsid);
-      Serial.println("' - pokracuje dal...");
-    }
+// A reading from the LAN: shown at once, and the user's cloud poll is put
+// off past the next expected reading (LAN_GRACE_MS). One that is not newer
+// than the history's newest is dropped (false): a delayed or replayed
+// record must neither put an older value on the display nor skew the
+// schedule.
+bool onLanReading(size_t u, const GlucoseReading& reading, uint32_t publishedAt, TraceSource source) {
+  const GlucoseHistory& history = users[u].history;
+  if (reading.timestamp == 0 || (history.size() > 0 && reading.timestamp <= history.latest().timestamp)) {
+    LOG_DEBUG("%sZaznam z LAN neni novejsi (%lu), zahozen", users[u].tag, (unsigned long)reading.timestamp);
+    return false;
   }
+  netSupervisor.onSuccess(millis());
+  // a push carries no publication time, publishedAt is its arrival
+  onGlucose(u, reading, source == TraceSource::Push ? 0 : publishedAt, source);
+  users[u].fetchDelayMs = userRtc[u].scheduler.onReading(reading.timestamp, publishedAt, unixNow()) + LAN_GRACE_MS;
+  users[u].lastFetchMs = millis();
+  return true;
+}
 
-  if (!connected) {
-    Serial.println("Nebyla nalezena zadna dostupna WiFi (vsechny pokusy selhaly).");
-  } else {
-    // initial fetch immediately after successful WiFi connection
-    fetchGlucose();
-    lastFetchMs = millis();
+#if GLUCOSE_LAN_PUSH
+// The record carries no publication time; arrival is close enough to it
+bool onPush(const char* uid, const GlucoseReading& reading) {
+  int u = userIndex(uid);
+  if (u < 0) {
+    LOG_WARN("Push: neznamy uzivatel '%s'", uid);
+    return false;
   }
+  LOG_DEBUG("%sPush z LAN", users[u].tag);
+  uint32_t now = unixNow();
+  // an old record is still a valid push; it is just not shared
+  if (onLanReading(u, reading, now, TraceSource::Push)) {
+    shareReading(u, reading, now);
+  }
+  return true;
+}
+#endif
+
+#if GLUCOSE_PEER
+// Peers also multicast users this display doesn't watch; those are ignored
+bool onPeerReading(const char* uid, const GlucoseReading& reading, uint32_t publishedAt) {
+  int u = userIndex(uid);
+  if (u < 0) {
+    return false;
+  }
+  return onLanReading(u, reading, publishedAt, TraceSource::Peer);
+}
+#endif
+
+// Idles up to ms while still answering the local server and peers, so a
+// push, a peer reading or a /metrics scrape doesn't wait out the pause;
+// a WiFi link change ends it early
+void idle(unsigned long ms) {
+  unsigned long start = millis();
+  do {
+    watchdogFeed();
+    localServerHandle();
+#if GLUCOSE_PEER
+    peerPoll();
+#endif
+    if (wifiLinkChangePending()) {
+      return; // reconnected or dropped: loop() reacts right away
+    }
+    delay(10);
+  } while (millis() - start < ms);
 }
 
 // Note: keep WiFi credentials out of source control. Use src/secrets.h (not committed) or environment-specific config.
 
-void fetchGlucose() {
+// All users share glucoseSession: same host, so HTTPClient keeps the one
+// TLS connection open from request to request and only the first fetch
+// after a drop pays the handshake.
+void fetchGlucose(size_t u) {
+  FetchScheduler& fetchScheduler = userRtc[u].scheduler;
+  char* lastEtag = userRtc[u].etag;
+  unsigned long& fetchDelayMs = users[u].fetchDelayMs;
+  watchdogFeed(); // each fetch is bounded by the session timeouts
   if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi neni pripojena, preskakuji stahovani");
-    WiFi.reconnect();
+    // superviseNetwork() reconnects, spaced out
+    LOG_WARN("WiFi neni pripojena, preskakuji stahovani");
+    glucoseSession.reset();
+    fetchDelayMs = fetchScheduler.onError(esp_random());
     return;
   }
 
-  WiFiClientSecure client;
-  client.setInsecure(); // NOTE: for simplicity; consider using proper root cert in production
-  HTTPClient http;
-  Serial.print("Stahuji: ");
-  Serial.println(GLUCOSE_URL);
-  if (http.begin(client, GLUCOSE_URL)) {
-    int httpCode = http.GET();
-    if (httpCode == HTTP_CODE_OK) {
-      String payload = http.getString();
-      Serial.println("Prijaty payload:");
-      Serial.println(payload);
-
-      // Parse JSON using ArduinoJson
-      DynamicJsonDocument doc(1024);
-      DeserializationError err = deserializeJson(doc, payload);
+  char url[URL_SIZE];
+  userUrl(url, u, GLUCOSE_FETCH_NODE);
+  LOG_DEBUG("Stahuji: %s", url);
+  fetchDelayMs = 0; // set below from the outcome
+  if (glucoseSession.begin(url)) {
+    HTTPClient& http = glucoseSession.http();
+    http.addHeader("X-Firebase-ETag", "true");
+    if (lastEtag[0] != '\0') {
+      http.addHeader("If-None-Match", lastEtag);
+    }
+    const char* headerKeys[] = { "ETag" };
+    http.collectHeaders(headerKeys, 1);
+
+    int httpCode = glucoseSession.GET();
+    if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_NOT_MODIFIED) {
+      netSupervisor.onSuccess(millis()); // the cloud answered
+    }
+    String etag = http.header("ETag");
+    if (httpCode == HTTP_CODE_NOT_MODIFIED
+        || (httpCode == HTTP_CODE_OK && etag.length() > 0 && etag.equals(lastEtag))) {
+      // same data as last time: skip parsing and display updates
+      LOG_DEBUG("Data beze zmeny (ETag)");
+      fetchDelayMs = fetchScheduler.onUnchanged();
+    } else if (httpCode == HTTP_CODE_OK) {
+#if GLUCOSE_COMPACT
+      // fixed-size body: read it in one go (RTDB sends Content-Length)
+      char body[COMPACT_BODY_SIZE];
+      int size = http.getSize();
+      size_t len = 0;
+      if (size > 0 && size <= (int)sizeof(body)) {
+        PhaseTimer timer(Phase::Body);
+        len = http.getStream().readBytes(body, size);
+      }
+      GlucoseReading reading;
+      bool decoded;
+      {
+        PhaseTimer timer(Phase::Parse);
+        decoded = decodeCompactReading(body, len, reading);
+      }
+      metricsSampleHeap();
+      if (decoded) {
+        strlcpy(lastEtag, etag.c_str(), sizeof(userRtc[u].etag));
+        onGlucose(u, reading, 0, TraceSource::Poll);
+        shareReading(u, reading, 0);
+        // the record has no publication time; the learned latency is kept
+        fetchDelayMs = fetchScheduler.onReading(reading.timestamp, 0, unixNow());
+      } else {
+        LOG_WARN("Neplatny kompaktni zaznam (%d B)", size);
+      }
+#else
+      // Parse straight from the socket; the filter drops every field we
+      // don't use, so the document size doesn't depend on the payload.
+      // (RTDB answers plain GETs with Content-Length, not chunked.)
+      StaticJsonDocument<LATEST_FILTER_CAPACITY> filter;
+      latestFilter(filter);
+      StaticJsonDocument<LATEST_DOC_CAPACITY> doc;
+      DeserializationError err;
+      {
+        PhaseTimer timer(Phase::Parse); // includes reading the body
+        err = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+      }
+      metricsSampleHeap();
       if (err) {
-        Serial.print("JSON parse error: ");
-        Serial.println(err.c_str());
+        LOG_ERROR("JSON parse error: %s", err.c_str());
       } else {
-        if (doc.containsKey("main") && doc["main"].is<JsonObject>()) {
-          JsonObject main = doc["main"].as<JsonObject>();
-          if (main.containsKey("glucose")) {
-            float glucose = main["glucose"].as<float>();
-            Serial.print("Hladina cukru: ");
-            Serial.println(glucose);
-            updateLedForGlucose(glucose);
-          } else {
-            Serial.println("Pole 'glucose' nebylo nalezeno v objektu 'main'.");
-          }
-        } else if (doc.containsKey("glucose")) {
-          // fallback: top-level glucose
-          float glucose = doc["glucose"].as<float>();
-          Serial.print("Hladina cukru: ");
-          Serial.println(glucose);
-          updateLedForGlucose(glucose);
-        } else {
-          Serial.println("Pole 'main' nebo 'glucose' nebylo nalezeno v JSONu.");
+        // remember the ETag only once its payload was parsed successfully
+        strlcpy(lastEtag, etag.c_str(), sizeof(userRtc[u].etag));
+        GlucoseReading reading;
+        uint32_t publishedAt;
+        switch (extractLatest(doc.as<JsonVariantConst>(), reading, publishedAt)) {
+          case LatestStatus::Main:
+            onGlucose(u, reading, publishedAt, TraceSource::Poll);
+            shareReading(u, reading, publishedAt);
+            fetchDelayMs = fetchScheduler.onReading(reading.timestamp, publishedAt, unixNow());
+            break;
+          case LatestStatus::TopLevel:
+            onGlucose(u, reading, 0, TraceSource::Poll);
+            fetchDelayMs = fetchScheduler.onUnchanged(); // no timestamp to align to
+            break;
+          case LatestStatus::NoGlucoseInMain:
+            LOG_WARN("Pole 'glucose' nebylo nalezeno v objektu 'main'.");
+            break;
+          case LatestStatus::NoGlucose:
+            LOG_WARN("Pole 'main' nebo 'glucose' nebylo nalezeno v JSONu.");
+            break;
         }
       }
+#endif
     } else {
-      Serial.print("HTTP GET selhalo, kod: ");
-      Serial.println(httpCode);
+      LOG_WARN("HTTP GET selhalo, kod: %d", httpCode);
     }
-    http.end();
+    glucoseSession.end();
   } else {
-    Serial.println("HTTP begin selhalo");
+    LOG_ERROR("HTTP begin selhalo");
+  }
+  if (fetchDelayMs == 0) {
+    // HTTP error or unusable payload
+    fetchDelayMs = fetchScheduler.onError(esp_random());
+  }
+  LOG_DEBUG("%sDalsi stahovani za %lu s (perioda %u s, zpozdeni %u s)", users[u].tag, fetchDelayMs / 1000,
+            (unsigned)fetchScheduler.periodS(), (unsigned)fetchScheduler.latencyS());
+}
+
+// One query for the recent history instead of starting the trend buffer
+// empty. The body is parsed straight from the socket; RTDB does not
+// guarantee key order in filtered results, so entries are sorted before
+// they go into the user's history (which only accepts newer readings).
+void backfillHistory(size_t u) {
+  watchdogFeed();
+  UserState& user = users[u];
+  char url[URL_SIZE];
+  userUrl(url, u, GLUCOSE_HISTORY_NODE);
+  if (!glucoseSession.begin(url)) {
+    LOG_ERROR("%sHistorie: HTTP begin selhalo", user.tag);
+    return;
+  }
+  int httpCode = glucoseSession.GET();
+  if (httpCode != HTTP_CODE_OK) {
+    LOG_WARN("%sHistorie: HTTP GET selhalo, kod: %d", user.tag, httpCode);
+    glucoseSession.end();
+    return;
+  }
+
+  std::unique_ptr<HistoryEntry[]> entries(new HistoryEntry[GlucoseHistory::CAPACITY]);
+  size_t count = 0;
+  HistoryParser parser;
+  HTTPClient& http = glucoseSession.http();
+  WiFiClient& stream = http.getStream();
+  int remaining = http.getSize(); // -1 if unknown
+  unsigned long lastDataMs = millis();
+  {
+    PhaseTimer timer(Phase::Body); // parsed while reading
+    while (remaining != 0 && http.connected() && millis() - lastDataMs < 5000) {
+      int c = stream.read();
+      if (c < 0) {
+        delay(1);
+        continue;
+      }
+      lastDataMs = millis();
+      if (remaining > 0) {
+        remaining--;
+      }
+      if (parser.feed((char)c) && count < GlucoseHistory::CAPACITY) {
+        entries[count++] = HistoryEntry{ parser.timestamp(), parser.mgdl() };
+      }
+    }
+  }
+  metricsSampleHeap(); // entries[] on top of the TLS session
+  glucoseSession.end();
+
+  std::sort(entries.get(), entries.get() + count,
+            [](const HistoryEntry& a, const HistoryEntry& b) { return a.timestamp < b.timestamp; });
+  size_t added = 0;
+  if (count > 0 && user.history.size() > 0 && entries[0].timestamp < user.history.at(0).timestamp) {
+    // the history restored at boot holds only the newest hours: the cloud
+    // reaches further back, so start from it and lay anything newer on top
+    std::unique_ptr<GlucoseHistory> merged(new GlucoseHistory);
+    for (size_t i = 0; i < count; ++i) {
+      merged->add(entries[i].timestamp, entries[i].mgdl);
+    }
+    for (size_t i = 0; i < user.history.size(); ++i) {
+      merged->add(user.history.at(i).timestamp, user.history.at(i).mgdl);
+    }
+    added = merged->size() - std::min(merged->size(), user.history.size());
+    user.history = *merged;
+  } else {
+    for (size_t i = 0; i < count; ++i) {
+      added += user.history.add(entries[i].timestamp, entries[i].mgdl) ? 1 : 0;
+    }
+  }
+  if (added > 0) {
+    cacheReadings(u);
   }
+  LOG_INFO("%sHistorie: nacteno %u zaznamu, pridano %u", user.tag, (unsigned)count, (unsigned)added);
 }
 
+// Reacts to the WiFi events (wifi_connect.h) as soon as idle() has
+// noticed one, instead of polling the status on every pass
+void onLinkChange() {
+  WifiLinkChange link;
+  if (!wifiTakeLinkChange(link)) {
+    return;
+  }
+  if (!link.up) {
+    LOG_WARN("WiFi odpojena (duvod %u)", (unsigned)link.reason);
+    glucoseStream.close();
+    glucoseSession.reset();
+    return;
+  }
+  LOG_INFO("WiFi opet pripojena po %lu s", link.downMs / 1000);
+  // after a long outage the trend buffer has a gap: fill it in one go
+  if (link.downMs >= BACKFILL_AFTER_OUTAGE_MS) {
+    for (size_t u = 0; u < USER_COUNT; ++u) {
+      backfillHistory(u);
+    }
+  }
+  // fetch at once instead of waiting out the error backoff
+  for (size_t u = 0; u < USER_COUNT; ++u) {
+    users[u].fetchDelayMs = 0;
+  }
+  lastStreamOpenMs = millis() - STREAM_RETRY_MS;
+}
+
+// Acts on the network supervisor (net_supervisor.h): spaced reconnects
+// while the link is down, a WiFi restart when nothing got through for
+// NET_RESTART_WIFI_MIN, a reboot when even that didn't help. A call that
+// hangs outright is left to the task watchdog (watchdog.h).
+void superviseNetwork() {
+  unsigned long now = millis();
+  if (STREAMING && glucoseStream.connected()) {
+    netSupervisor.onSuccess(now); // keep-alives arrive every 30 s
+  }
+  switch (netSupervisor.poll(now, WiFi.status() == WL_CONNECTED)) {
+    case NetAction::None:
+      break;
+    case NetAction::Reconnect:
+      wifiReconnect(wifiCreds, wifiCredsCount);
+      break;
+    case NetAction::RestartWifi:
+      LOG_WARN("Bez odpovedi %lu min, restartuji WiFi", netSupervisor.quietMs(now) / 60000UL);
+      glucoseStream.close();
+      glucoseSession.reset();
+      WiFi.disconnect(true);
+      delay(100);
+      wifiConnect(wifiCreds, wifiCredsCount);
+      break;
+    case NetAction::Reboot:
+      LOG_ERROR("Bez odpovedi %lu min ani po restartu WiFi, restartuji zarizeni",
+                netSupervisor.quietMs(now) / 60000UL);
+      logFlush();
+      ESP.restart();
+      break;
+  }
+}
+
+// loop() is the network task: everything in here may block on WiFi or
+// HTTPS, rendering happens in displayTask() and the LED engine
 void loop()
 {
+  watchdogFeed();
   loopCount++;
-  Serial.print("Pocet pruchodu loop(): ");
-  Serial.println(loopCount);
+  LOG_TRACE("Pocet pruchodu loop(): %lu", loopCount);
+  metricsSampleHeap();
+  consolePoll(); // "metrics", "config", "wifi add ..." (console.h)
+  localServerHandle();
+#if GLUCOSE_PEER
+  peerPoll();
+#endif
 
-  // If WiFi disconnected, try to reconnect (non-blocking)
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("WiFi neni pripojena, pokusim se znovu pripojit...");
-    WiFi.reconnect();
+  onLinkChange();
+  superviseNetwork();
+  reportTraces();
+  ledEngineSetBrightness(ledBrightnessAt(localHour()));
+  updateLeds();
+#if GLUCOSE_OTA
+  otaPoll();
+  if (otaCheckDue()) {
+    // the image download needs the heap of the RTDB connection; the
+    // stream reopens on its own
+    glucoseStream.close();
+    glucoseSession.reset();
+    char manifestUrl[URL_SIZE];
+    snprintf(manifestUrl, sizeof(manifestUrl), "%s/firmware/%s.json", settings.rtdbUrl, OTA_CHANNEL);
+    otaCheck(manifestUrl);
   }
+#endif
 
-  unsigned long now = millis();
-  if (now - lastFetchMs >= FETCH_INTERVAL_MS) {
-    fetchGlucose();
-    lastFetchMs = now;
-  }
+#if LOW_POWER_MODE != LOW_POWER_OFF
+  // setup() already fetched once; sleep, then fetch after waking up
+  sleepUntilNextFetch();
+  fetchAllUsers();
+#else
+  if (STREAMING) {
+    unsigned long now = millis();
+    if (WiFi.status() == WL_CONNECTED && !glucoseStream.connected()
+        && now - lastStreamOpenMs >= STREAM_RETRY_MS) {
+      glucoseStream.open();
+      lastStreamOpenMs = now;
+    }
+    GlucoseReading reading;
+    uint32_t publishedAt;
+    if (glucoseStream.poll(reading, publishedAt)) {
+      onGlucose(0, reading, publishedAt, TraceSource::Stream);
+      shareReading(0, reading, publishedAt);
+    }
 
-  // Idle a bit to reduce CPU usage
-  delay(1000);
+    // Idle until the stream has new data (at most 1 s); while it is
+    // down, until a link change
+    if (glucoseStream.connected()) {
+      glucoseStream.waitForData(1000);
+    } else {
+      idle(1000);
+    }
+  } else {
+    fetchDueUsers();
+
+    // Idle a bit to reduce CPU usage
+    idle(1000);
+  }
+#endif
 }
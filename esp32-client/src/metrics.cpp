@@ -0,0 +1,127 @@
+#include "metrics.h"
+
+#include "latency_histogram.h"
+
+static const char* const PHASE_NAMES[] = {
+  "dns", "connect", "first_byte", "body", "parse", "render",
+};
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == (size_t)Phase::COUNT,
+              "PHASE_NAMES out of sync with Phase");
+
+static LatencyHistogram histograms[(size_t)Phase::COUNT];
+// recorded from the network and display tasks, read by both dumps
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint32_t minFreeHeap = UINT32_MAX;
+static uint32_t minMaxAlloc = UINT32_MAX;
+
+void metricsRecord(Phase phase, uint32_t us) {
+  portENTER_CRITICAL(&metricsMux);
+  histograms[(size_t)phase].add(us);
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsSampleHeap() {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxAlloc = ESP.getMaxAllocHeap();
+  if (freeHeap < minFreeHeap) {
+    minFreeHeap = freeHeap;
+  }
+  if (maxAlloc < minMaxAlloc) {
+    minMaxAlloc = maxAlloc;
+  }
+}
+
+// Consistent copy, so printing (slow) happens outside the critical section
+static void snapshot(LatencyHistogram* out) {
+  portENTER_CRITICAL(&metricsMux);
+  for (size_t i = 0; i < (size_t)Phase::COUNT; ++i) {
+    out[i] = histograms[i];
+  }
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsDump(Print& out) {
+  LatencyHistogram copy[(size_t)Phase::COUNT];
+  snapshot(copy);
+  out.printf("%-11s %7s %9s %9s %9s %9s %9s\n", "phase", "count", "min ms", "avg ms", "p50 ms", "p90 ms", "max ms");
+  for (size_t i = 0; i < (size_t)Phase::COUNT; ++i) {
+    const LatencyHistogram& h = copy[i];
+    uint32_t avg = h.count() ? (uint32_t)(h.sumUs() / h.count()) : 0;
+    out.printf("%-11s %7u %9.1f %9.1f %9.1f %9.1f %9.1f\n", PHASE_NAMES[i], (unsigned)h.count(),
+               h.minUs() / 1000.0f, avg / 1000.0f, h.percentileUs(50) / 1000.0f,
+               h.percentileUs(90) / 1000.0f, h.maxUs() / 1000.0f);
+  }
+  out.printf("heap: free %u (min %u, system min %u), largest block %u (min %u)\n",
+             (unsigned)ESP.getFreeHeap(), (unsigned)minFreeHeap, (unsigned)ESP.getMinFreeHeap(),
+             (unsigned)ESP.getMaxAllocHeap(), (unsigned)minMaxAlloc);
+}
+
+void metricsPrometheus(Print& out) {
+  LatencyHistogram copy[(size_t)Phase::COUNT];
+  snapshot(copy);
+  out.print("# TYPE gluco_phase_seconds histogram\n");
+  for (size_t i = 0; i < (size_t)Phase::COUNT; ++i) {
+    const LatencyHistogram& h = copy[i];
+    uint32_t cumulative = 0;
+    for (size_t b = 0; b + 1 < LatencyHistogram::BUCKETS; ++b) {
+      cumulative += h.bucket(b);
+      out.printf("gluco_phase_seconds_bucket{phase=\"%s\",le=\"%.3f\"} %u\n", PHASE_NAMES[i],
+                 LatencyHistogram::bucketLimitUs(b) / 1e6f, (unsigned)cumulative);
+    }
+    out.printf("gluco_phase_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %u\n", PHASE_NAMES[i], (unsigned)h.count());
+    out.printf("gluco_phase_seconds_sum{phase=\"%s\"} %.6f\n", PHASE_NAMES[i], h.sumUs() / 1e6f);
+    out.printf("gluco_phase_seconds_count{phase=\"%s\"} %u\n", PHASE_NAMES[i], (unsigned)h.count());
+  }
+  out.print("# TYPE gluco_heap_free_bytes gauge\n");
+  out.printf("gluco_heap_free_bytes %u\n", (unsigned)ESP.getFreeHeap());
+  out.printf("gluco_heap_free_min_bytes %u\n", (unsigned)minFreeHeap);
+  out.printf("gluco_heap_system_min_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+  out.print("# TYPE gluco_heap_largest_block_bytes gauge\n");
+  out.printf("gluco_heap_largest_block_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+  out.printf("gluco_heap_largest_block_min_bytes %u\n", (unsigned)minMaxAlloc);
+}
+
+static WebServer* server = nullptr;
+
+// Print adapter that streams the response in chunks instead of building
+// one String with the whole body
+class ChunkedResponse : public Print {
+public:
+  explicit ChunkedResponse(WebServer& server) : _server(server), _len(0) {}
+  ~ChunkedResponse() { sendBuffered(); }
+
+  size_t write(uint8_t c) override {
+    _buf[_len++] = (char)c;
+    if (_len == sizeof(_buf)) {
+      sendBuffered();
+    }
+    return 1;
+  }
+  void sendBuffered() {
+    if (_len > 0) {
+      _server.sendContent(_buf, _len);
+      _len = 0;
+    }
+  }
+
+private:
+  WebServer& _server;
+  char _buf[256];
+  size_t _len;
+};
+
+static void handleMetrics() {
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, "text/plain; version=0.0.4", "");
+  {
+    ChunkedResponse out(*server);
+    metricsPrometheus(out);
+  }
+  server->sendContent(""); // end of chunked body
+}
+
+void metricsRoutes(WebServer& s) {
+  server = &s;
+  server->on("/metrics", HTTP_GET, handleMetrics);
+}
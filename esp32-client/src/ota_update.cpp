@@ -0,0 +1,288 @@
+#include "ota_update.h"
+
+#include <Preferences.h>
+#include <Update.h>
+#include <WiFi.h>
+#include <esp_ota_ops.h>
+#include <rom/miniz.h>
+#include <algorithm>
+#include <memory>
+#include <time.h>
+#include "https_session.h"
+#include "log.h"
+#include "metrics.h"
+#include "watchdog.h"
+
+// NVS keys: "trial" and "boots" while a new image is on trial, "skip" is
+// the version that was rolled back (not installed again)
+static const char* NVS_NAMESPACE = "ota";
+static const unsigned long TRIAL_MS = OTA_TRIAL_MIN * 60UL * 1000UL;
+static const uint32_t CHECK_INTERVAL_S = OTA_CHECK_INTERVAL_H * 3600UL;
+static const uint16_t DATA_TIMEOUT_MS = 10000;
+static const size_t IN_BUFFER_SIZE = 1024;
+
+// Wall-clock time of the last check; RTC memory is kept through deep
+// sleep, so battery builds don't check on every wake-up
+RTC_DATA_ATTR static uint32_t lastCheckAt = 0;
+static bool trial = false;
+static uint32_t skipVersion = 0;
+
+// With a rollback-enabled bootloader the core marks the running image
+// valid right at boot unless this says otherwise; otaConfirm() does it
+// after the first reading instead
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
+static uint32_t unixTime() {
+  time_t now = time(nullptr);
+  return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+static void endTrial() {
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.remove("trial");
+  prefs.remove("boots");
+  prefs.end();
+  trial = false;
+}
+
+// Back to the image in the other OTA slot; returns only if there is none
+static void rollBack(const char* why) {
+  LOG_ERROR("OTA: %s, vracim predchozi firmware", why);
+  endTrial();
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.putUInt("skip", FIRMWARE_VERSION);
+  prefs.end();
+  logFlush();
+
+  esp_ota_img_states_t state;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK
+      && state == ESP_OTA_IMG_PENDING_VERIFY) {
+    esp_ota_mark_app_invalid_rollback_and_reboot(); // restarts on success
+  }
+  // bootloader without rollback support: boot the other slot directly
+  const esp_partition_t* previous = esp_ota_get_next_update_partition(nullptr);
+  esp_app_desc_t desc;
+  if (previous && esp_ota_get_partition_description(previous, &desc) == ESP_OK
+      && esp_ota_set_boot_partition(previous) == ESP_OK) {
+    ESP.restart();
+  }
+  LOG_ERROR("OTA: predchozi firmware neni k dispozici, zustavam u verze %u", (unsigned)FIRMWARE_VERSION);
+}
+
+void otaBegin() {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    return;
+  }
+  skipVersion = prefs.getUInt("skip", 0);
+  trial = prefs.getBool("trial", false);
+  uint8_t boots = 0;
+  if (trial) {
+    boots = prefs.getUChar("boots", 0) + 1;
+    prefs.putUChar("boots", boots);
+  }
+  prefs.end();
+  if (!trial) {
+    return;
+  }
+  if (boots > OTA_TRIAL_BOOTS) {
+    rollBack("nova verze bez mereni po vice startech");
+    return;
+  }
+  LOG_INFO("OTA: verze %u na zkousku (start %u/%u)", (unsigned)FIRMWARE_VERSION, boots, OTA_TRIAL_BOOTS);
+}
+
+void otaConfirm() {
+  if (!trial) {
+    return;
+  }
+  esp_ota_mark_app_valid_cancel_rollback();
+  endTrial();
+  LOG_INFO("OTA: verze %u potvrzena", (unsigned)FIRMWARE_VERSION);
+}
+
+void otaPoll() {
+  if (trial && millis() >= TRIAL_MS) {
+    rollBack("nova verze nedostala mereni vcas");
+  }
+}
+
+bool otaCheckDue() {
+  uint32_t now = unixTime();
+  return !trial && now != 0 && WiFi.status() == WL_CONNECTED
+         && (lastCheckAt == 0 || now - lastCheckAt >= CHECK_INTERVAL_S);
+}
+
+// The response body with a known length, read as it arrives
+struct BodyReader {
+  WiFiClient& stream;
+  int remaining;
+
+  // 0 once the body is complete, the connection closed or stalled
+  size_t read(uint8_t* buf, size_t len) {
+    watchdogFeed(); // the download takes far longer than the watchdog
+    unsigned long lastDataMs = millis();
+    while (remaining > 0) {
+      int available = stream.available();
+      if (available > 0) {
+        size_t n = std::min(len, (size_t)std::min(available, remaining));
+        n = stream.read(buf, n);
+        remaining -= n;
+        return n;
+      }
+      if (!stream.connected() || millis() - lastDataMs >= DATA_TIMEOUT_MS) {
+        return 0;
+      }
+      delay(1);
+    }
+    return 0;
+  }
+};
+
+static bool copyImage(BodyReader& body, uint8_t* in, size_t inLen) {
+  while (inLen > 0) {
+    if (Update.write(in, inLen) != inLen) {
+      return false;
+    }
+    inLen = body.read(in, IN_BUFFER_SIZE);
+  }
+  return body.remaining == 0;
+}
+
+// Inflates with the ROM's miniz (no code in flash for it). The output
+// buffer doubles as the 32 KB deflate window: tinfl writes it as a ring,
+// and every chunk goes to flash before it is overwritten. The gzip
+// trailer is not checked; Update verifies size and MD5 of the image.
+static bool inflateImage(BodyReader& body, uint8_t* in, size_t inLen, size_t inPos) {
+  std::unique_ptr<tinfl_decompressor> inflator(new tinfl_decompressor);
+  std::unique_ptr<uint8_t[]> window(new uint8_t[TINFL_LZ_DICT_SIZE]);
+  metricsSampleHeap(); // the lowest point of an update
+  tinfl_init(inflator.get());
+  size_t outPos = 0;
+  for (;;) {
+    if (inPos == inLen && body.remaining > 0) {
+      inLen = body.read(in, IN_BUFFER_SIZE);
+      inPos = 0;
+      if (inLen == 0) {
+        return false; // stalled
+      }
+    }
+    size_t inBytes = inLen - inPos;
+    size_t outBytes = TINFL_LZ_DICT_SIZE - outPos;
+    mz_uint32 flags = body.remaining > 0 ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+    tinfl_status status = tinfl_decompress(inflator.get(), in + inPos, &inBytes, window.get(),
+                                           window.get() + outPos, &outBytes, flags);
+    inPos += inBytes;
+    if (outBytes > 0 && Update.write(window.get() + outPos, outBytes) != outBytes) {
+      return false;
+    }
+    outPos = (outPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+    if (status == TINFL_STATUS_DONE) {
+      return true;
+    }
+    if (status < TINFL_STATUS_DONE || (status == TINFL_STATUS_NEEDS_MORE_INPUT && body.remaining == 0)) {
+      return false; // corrupt or truncated
+    }
+  }
+}
+
+static bool install(const OtaManifest& manifest) {
+  HttpsSession session(DATA_TIMEOUT_MS);
+  if (!session.begin(manifest.url)) {
+    LOG_ERROR("OTA: HTTP begin selhalo");
+    return false;
+  }
+  int code = session.GET();
+  int size = session.http().getSize();
+  if (code != HTTP_CODE_OK || size <= 0) {
+    LOG_WARN("OTA: stazeni selhalo, kod: %d, delka: %d", code, size);
+    session.reset();
+    return false;
+  }
+  if (!Update.begin(manifest.size)) {
+    LOG_ERROR("OTA: %s", Update.errorString());
+    session.reset();
+    return false;
+  }
+  Update.setMD5(manifest.md5);
+
+  unsigned long startMs = millis();
+  WiFi.setSleep(false); // modem sleep would stretch the download
+  BodyReader body{ session.http().getStream(), size };
+  std::unique_ptr<uint8_t[]> in(new uint8_t[IN_BUFFER_SIZE]);
+  // plain images start with 0xe9, so one byte tells them apart
+  size_t inLen = 0;
+  long header = 0;
+  while (header == 0 && inLen < IN_BUFFER_SIZE) {
+    size_t n = body.read(in.get() + inLen, IN_BUFFER_SIZE - inLen);
+    if (n == 0) {
+      break;
+    }
+    inLen += n;
+    header = gzipHeaderSize(in.get(), inLen);
+  }
+  bool gzip = header > 0;
+  bool ok = header < 0 ? copyImage(body, in.get(), inLen)
+                       : header > 0 && inflateImage(body, in.get(), inLen, (size_t)header);
+  WiFi.setSleep(true);
+  session.reset();
+
+  if (!ok || !Update.end()) {
+    LOG_ERROR("OTA: zapis selhal: %s", Update.hasError() ? Update.errorString() : "neuplna data");
+    Update.abort();
+    return false;
+  }
+  LOG_INFO("OTA: %d B%s stazeno za %lu s, obraz %lu B", size, gzip ? " (gzip)" : "",
+           (millis() - startMs) / 1000, (unsigned long)manifest.size);
+  return true;
+}
+
+void otaCheck(const char* manifestUrl) {
+  lastCheckAt = unixTime();
+  OtaManifest manifest;
+  {
+    HttpsSession session;
+    if (!session.begin(manifestUrl)) {
+      LOG_ERROR("OTA: HTTP begin selhalo");
+      return;
+    }
+    int code = session.GET();
+    if (code != HTTP_CODE_OK) {
+      LOG_WARN("OTA: manifest HTTP GET selhalo, kod: %d", code);
+      session.reset();
+      return;
+    }
+    StaticJsonDocument<OTA_MANIFEST_DOC_CAPACITY> doc;
+    DeserializationError err = deserializeJson(doc, session.http().getStream());
+    session.reset();
+    if (!err && doc.isNull()) {
+      LOG_DEBUG("OTA: zadny manifest");
+      return;
+    }
+    if (err || !parseOtaManifest(doc.as<JsonVariantConst>(), manifest)) {
+      LOG_WARN("OTA: neplatny manifest");
+      return;
+    }
+  }
+  if (manifest.version <= FIRMWARE_VERSION || manifest.version == skipVersion) {
+    LOG_DEBUG("OTA: verze %lu, bezi %u", (unsigned long)manifest.version, (unsigned)FIRMWARE_VERSION);
+    return;
+  }
+
+  LOG_INFO("OTA: stahuji verzi %lu", (unsigned long)manifest.version);
+  if (!install(manifest)) {
+    return;
+  }
+  Preferences prefs;
+  prefs.begin(NVS_NAMESPACE, false);
+  prefs.putBool("trial", true);
+  prefs.putUChar("boots", 0);
+  prefs.end();
+  LOG_INFO("OTA: restartuji do verze %lu", (unsigned long)manifest.version);
+  logFlush();
+  ESP.restart();
+}
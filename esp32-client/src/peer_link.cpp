@@ -0,0 +1,136 @@
+#include "peer_link.h"
+
+#include <ESPmDNS.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <time.h>
+#include "device_id.h"
+#include "log.h"
+
+static const unsigned long HELLO_INTERVAL_MS = 10000;
+
+static WiFiUDP udp;
+static const IPAddress group(PEER_GROUP);
+static uint32_t self = 0;
+static uint32_t epoch = 0;
+static uint32_t seq = 0;
+static PeerTable* peers = nullptr;
+static PeerReadingHandler readingHandler = nullptr;
+static const char* peerKey = "";
+static IPAddress joinedIp;
+static bool joined = false;
+static bool wasLeader = true;
+static unsigned long lastHelloMs = 0;
+
+static uint32_t unixTime() {
+  time_t now = time(nullptr);
+  return now > 1600000000 ? (uint32_t)now : 0;
+}
+
+static void send(PeerPacket& packet) {
+  if (!joined) {
+    return;
+  }
+  packet.sender = self;
+  packet.epoch = epoch;
+  packet.seq = ++seq;
+  packet.sentAt = unixTime();
+  uint8_t buf[PEER_PACKET_MAX];
+  size_t len = encodePeerPacket(packet, peerKey, buf, sizeof(buf));
+  if (len == 0) {
+    return;
+  }
+  udp.beginMulticastPacket();
+  udp.write(buf, len);
+  udp.endPacket();
+}
+
+static void sendHello() {
+  PeerPacket packet{};
+  packet.type = PeerType::Hello;
+  send(packet);
+  lastHelloMs = millis();
+}
+
+// A new IP (DHCP renewal, other AP) drops the group membership
+static void join() {
+  IPAddress ip = WiFi.localIP();
+  if (joined && ip == joinedIp) {
+    return;
+  }
+  udp.stop();
+  joined = udp.beginMulticast(group, PEER_PORT) == 1;
+  joinedIp = ip;
+  if (!joined) {
+    LOG_WARN("Peer: pripojeni k multicast skupine selhalo");
+    return;
+  }
+  static bool mdnsStarted = false;
+  const char* name = deviceName();
+  if (!mdnsStarted && MDNS.begin(name)) {
+    MDNS.addService("glucowatch", "udp", PEER_PORT);
+    mdnsStarted = true;
+  }
+  LOG_INFO("Peer: %s, skupina %s:%u", name, group.toString().c_str(), (unsigned)PEER_PORT);
+  sendHello(); // announce at once, so a new leader is seen quickly
+}
+
+void peerBegin(PeerReadingHandler handler, const char* key) {
+  if (key[0] == '\0') {
+    LOG_WARN("Peer: chybi token (klic paketu), sdileni vypnuto");
+    return;
+  }
+  readingHandler = handler;
+  peerKey = key;
+  self = deviceId();
+  epoch = esp_random();
+  peers = new PeerTable(self);
+}
+
+void peerPoll() {
+  if (peers == nullptr || WiFi.status() != WL_CONNECTED) {
+    return;
+  }
+  join();
+  if (!joined) {
+    return;
+  }
+  uint8_t buf[PEER_PACKET_MAX + 1];
+  while (udp.parsePacket() > 0) {
+    int len = udp.read(buf, sizeof(buf));
+    PeerPacket packet;
+    if (len <= 0 || !decodePeerPacket(buf, (size_t)len, peerKey, packet) || !peers->accept(packet, millis())) {
+      continue;
+    }
+    if (packet.type == PeerType::Reading) {
+      LOG_DEBUG("Peer: %s od %08lx (seq %lu)", packet.uid, (unsigned long)packet.sender,
+                (unsigned long)packet.seq);
+      readingHandler(packet.uid, packet.reading, packet.publishedAt);
+    }
+  }
+  if (millis() - lastHelloMs >= HELLO_INTERVAL_MS) {
+    sendHello();
+  }
+  bool leader = peers->isLeader(millis());
+  if (leader != wasLeader) {
+    LOG_INFO("Peer: %s", leader ? "tento displej stahuje z cloudu" : "data bere od jineho displeje");
+    wasLeader = leader;
+  }
+}
+
+void peerBroadcast(const char* uid, const GlucoseReading& reading, uint32_t publishedAt) {
+  PeerPacket packet{};
+  packet.type = PeerType::Reading;
+  strlcpy(packet.uid, uid, sizeof(packet.uid));
+  packet.reading = reading;
+  packet.publishedAt = publishedAt;
+  send(packet);
+}
+
+bool peerIsLeader() {
+  return peers == nullptr || peers->isLeader(millis());
+}
+
+size_t peerCount() {
+  return peers == nullptr ? 0 : peers->alive(millis());
+}
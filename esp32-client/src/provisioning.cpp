@@ -0,0 +1,159 @@
+#include "provisioning.h"
+
+#include <DNSServer.h>
+#include <WebServer.h>
+#include <WiFi.h>
+#include "device_id.h"
+#include "log.h"
+#include "settings_store.h"
+#include "watchdog.h"
+
+static const size_t MAX_SCANNED = 12;
+static const unsigned long TIMEOUT_MS = PROVISIONING_TIMEOUT_S * 1000UL;
+// url and token are only offered behind a password, see provisioning.h
+static const bool PROTECTED = PROVISIONING_AP_PASS[0] != '\0';
+
+static WebServer* server = nullptr;
+static DeviceSettings draft;
+static char scanned[MAX_SCANNED][SETTINGS_SSID_SIZE]; // offered in the form
+static size_t scannedCount = 0;
+static bool saved = false;
+
+// Sends text with the HTML special characters escaped
+static void sendEscaped(const char* text) {
+  char buf[64];
+  size_t len = 0;
+  for (; *text; ++text) {
+    const char* entity = nullptr;
+    switch (*text) {
+      case '&': entity = "&amp;"; break;
+      case '<': entity = "&lt;"; break;
+      case '>': entity = "&gt;"; break;
+      case '"': entity = "&quot;"; break;
+      case '\'': entity = "&#39;"; break;
+    }
+    size_t need = entity ? strlen(entity) : 1;
+    if (len + need > sizeof(buf)) {
+      server->sendContent(buf, len);
+      len = 0;
+    }
+    if (entity) {
+      memcpy(buf + len, entity, need);
+    } else {
+      buf[len] = *text;
+    }
+    len += need;
+  }
+  if (len > 0) {
+    server->sendContent(buf, len);
+  }
+}
+
+static void handleRoot() {
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, "text/html; charset=utf-8", "");
+  server->sendContent("<!DOCTYPE html><meta name=viewport content='width=device-width'>"
+                      "<title>gluco-watch</title><h1>gluco-watch</h1>"
+                      "<form method=post action=/save>"
+                      "<p>WiFi sit<br><input name=ssid list=nets required maxlength=32><datalist id=nets>");
+  for (size_t i = 0; i < scannedCount; ++i) {
+    server->sendContent("<option value=\"");
+    sendEscaped(scanned[i]);
+    server->sendContent("\">");
+  }
+  server->sendContent("</datalist><p>Heslo<br><input name=pass type=password maxlength=63>");
+  if (PROTECTED) {
+    server->sendContent("<p>RTDB url<br><input name=url size=50 value=\"");
+    sendEscaped(draft.rtdbUrl);
+    server->sendContent("\"><p>Push token<br><input name=token type=password placeholder='beze zmeny'>");
+  }
+  server->sendContent("<p><button>Ulozit a restartovat</button></form><p>Ulozene site:");
+  for (size_t i = 0; i < draft.wifiCount; ++i) {
+    server->sendContent(i ? ", " : " ");
+    sendEscaped(draft.wifi[i].ssid);
+  }
+  server->sendContent("");
+}
+
+static void handleSave() {
+  String url = server->arg("url");
+  String token = server->arg("token");
+  if (!PROTECTED && (url.length() > 0 || token.length() > 0)) {
+    LOG_WARN("Nastaveni: url a token nelze menit v otevrene siti");
+    server->send(403, "text/plain", "Url a token jen se sifrovanou siti (PROVISIONING_AP_PASS)");
+    return;
+  }
+  bool ok = settingsAddWifi(draft, server->arg("ssid").c_str(), server->arg("pass").c_str());
+  ok = ok && (url.length() == 0 || settingsSetUrl(draft, url.c_str()));
+  ok = ok && (token.length() == 0 || settingsSetToken(draft, token.c_str()));
+  if (!ok) {
+    server->send(400, "text/plain", "Neplatne udaje (sit je plna, nebo je hodnota prilis dlouha)");
+    return;
+  }
+  if (!settingsSave(draft)) {
+    server->send(500, "text/plain", "Ulozeni selhalo");
+    return;
+  }
+  server->send(200, "text/plain", "Ulozeno, restartuji...");
+  saved = true;
+}
+
+// Phones probe fixed URLs to detect a portal; anything unknown goes to
+// the form
+static void handleNotFound() {
+  server->sendHeader("Location", String("http://") + WiFi.softAPIP().toString() + "/", true);
+  server->send(302, "text/plain", "");
+}
+
+static void scan() {
+  int16_t found = WiFi.scanNetworks();
+  for (int16_t i = 0; i < found && scannedCount < MAX_SCANNED; ++i) {
+    String ssid = WiFi.SSID(i);
+    bool duplicate = ssid.length() == 0 || ssid.length() >= SETTINGS_SSID_SIZE;
+    for (size_t j = 0; j < scannedCount && !duplicate; ++j) {
+      duplicate = ssid.equals(scanned[j]);
+    }
+    if (!duplicate) {
+      strlcpy(scanned[scannedCount++], ssid.c_str(), SETTINGS_SSID_SIZE);
+    }
+  }
+  WiFi.scanDelete();
+}
+
+void provisioningRun(const DeviceSettings& settings) {
+  draft = settings;
+  WiFi.mode(WIFI_STA);
+  scan(); // before the AP is up, so the page can offer what's in range
+
+  const char* name = deviceName();
+  WiFi.mode(WIFI_AP);
+  WiFi.softAP(name, PROTECTED ? PROVISIONING_AP_PASS : nullptr);
+  IPAddress ip = WiFi.softAPIP();
+  LOG_WARN("Nastaveni: pripojte se k WiFi '%s' a otevrete http://%s/", name, ip.toString().c_str());
+
+  DNSServer dns;
+  dns.start(53, "*", ip);
+  WebServer web(80);
+  server = &web;
+  web.on("/", HTTP_GET, handleRoot);
+  web.on("/save", HTTP_POST, handleSave);
+  web.onNotFound(handleNotFound);
+  web.begin();
+
+  unsigned long start = millis();
+  while (!saved && millis() - start < TIMEOUT_MS) {
+    watchdogFeed();
+    dns.processNextRequest();
+    web.handleClient();
+    delay(5);
+  }
+  if (saved) {
+    delay(500); // let the reply reach the phone
+  } else {
+    LOG_INFO("Nastaveni: cas vyprsel, zkusim znovu zname site");
+  }
+  logFlush();
+  ESP.restart();
+  for (;;) {
+  }
+}
@@ -0,0 +1,33 @@
+#include "reading_store.h"
+
+#include <Preferences.h>
+
+static const char* NVS_NAMESPACE = "readings";
+
+static void key(char* out, size_t size, size_t user) {
+  snprintf(out, size, "u%u", (unsigned)user);
+}
+
+bool readingStoreLoad(size_t user, ReadingCache& cache) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) {
+    return false; // never saved
+  }
+  char name[8];
+  key(name, sizeof(name), user);
+  size_t len = prefs.getBytes(name, &cache, sizeof(cache));
+  prefs.end();
+  return len == sizeof(cache);
+}
+
+bool readingStoreSave(size_t user, const ReadingCache& cache) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    return false;
+  }
+  char name[8];
+  key(name, sizeof(name), user);
+  bool ok = prefs.putBytes(name, &cache, sizeof(cache)) == sizeof(cache);
+  prefs.end();
+  return ok;
+}
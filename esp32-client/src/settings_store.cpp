@@ -0,0 +1,54 @@
+#include "settings_store.h"
+
+#include <Preferences.h>
+#include <memory>
+
+// the whole struct as one blob ("settings"/"blob"): one read at boot
+static const char* NVS_NAMESPACE = "settings";
+static const char* NVS_KEY = "blob";
+
+bool settingsLoad(DeviceSettings& settings) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) {
+    return false; // never saved
+  }
+  // read into a scratch copy: a broken blob must not touch the defaults
+  std::unique_ptr<DeviceSettings> stored(new DeviceSettings);
+  size_t len = prefs.getBytes(NVS_KEY, stored.get(), sizeof(DeviceSettings));
+  prefs.end();
+  if (len != sizeof(DeviceSettings) || !settingsValid(*stored)) {
+    return false;
+  }
+  settings = *stored;
+  return true;
+}
+
+bool settingsSave(const DeviceSettings& settings) {
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, false)) {
+    return false;
+  }
+  bool ok = prefs.putBytes(NVS_KEY, &settings, sizeof(settings)) == sizeof(settings);
+  prefs.end();
+  return ok;
+}
+
+void settingsErase() {
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, false)) {
+    prefs.remove(NVS_KEY);
+    prefs.end();
+  }
+}
+
+void settingsPrint(const DeviceSettings& settings, Print& out) {
+  for (size_t i = 0; i < settings.wifiCount; ++i) {
+    out.printf("wifi %u: '%s'%s\n", (unsigned)(i + 1), settings.wifi[i].ssid,
+               settings.wifi[i].pass[0] ? " (heslo ****)" : " (otevrena)");
+  }
+  if (settings.wifiCount == 0) {
+    out.print("wifi: zadna sit\n");
+  }
+  out.printf("url: %s\n", settings.rtdbUrl);
+  out.printf("token: %s\n", settings.pushToken[0] ? "****" : "(nenastaven)");
+}
@@ -0,0 +1,76 @@
+#include "trace_report.h"
+
+#include "log.h"
+
+static const char* const* ids = nullptr;
+static const TraceWindow* windows = nullptr;
+static size_t userCount = 0;
+
+void traceBegin(const char* const* userIds, const TraceWindow* traceWindows, size_t users) {
+  ids = userIds;
+  windows = traceWindows;
+  userCount = users;
+}
+
+// ms as seconds with one decimal
+static void printSeconds(Print& out, uint32_t ms) {
+  out.printf(" %7lu.%lu", (unsigned long)(ms / 1000), (unsigned long)(ms % 1000 / 100));
+}
+
+static void printRow(Print& out, const char* name, const TraceStats& stats) {
+  out.printf("  %-16s %5u", name, (unsigned)stats.count);
+  printSeconds(out, stats.p50Ms);
+  printSeconds(out, stats.p90Ms);
+  printSeconds(out, stats.p99Ms);
+  printSeconds(out, stats.maxMs);
+  out.print("\n");
+}
+
+void traceDump(Print& out) {
+  for (size_t u = 0; u < userCount; ++u) {
+    const TraceWindow& window = windows[u];
+    out.printf("%s: posledni %u cteni\n", ids[u], (unsigned)window.size());
+    out.printf("  %-16s %5s %9s %9s %9s %9s\n", "stage", "count", "p50 s", "p90 s", "p99 s", "max s");
+    for (size_t s = 0; s < (size_t)TraceStage::COUNT; ++s) {
+      printRow(out, traceStageName((TraceStage)s), window.stats((TraceStage)s));
+    }
+    for (size_t s = 0; s < (size_t)TraceSource::Any; ++s) {
+      TraceStats stats = window.stats(TraceStage::Receive, (TraceSource)s);
+      if (stats.count > 0) {
+        char name[24];
+        snprintf(name, sizeof(name), "receive/%s", traceSourceName((TraceSource)s));
+        printRow(out, name, stats);
+      }
+    }
+  }
+}
+
+void traceLog() {
+  for (size_t u = 0; u < userCount; ++u) {
+    for (size_t s = 0; s < (size_t)TraceStage::COUNT; ++s) {
+      TraceStats stats = windows[u].stats((TraceStage)s);
+      if (stats.count == 0) {
+        continue;
+      }
+      LOG_INFO("%s: latence %s (%u): p50 %lu ms, p90 %lu ms, p99 %lu ms, max %lu ms", ids[u],
+               traceStageName((TraceStage)s), (unsigned)stats.count, (unsigned long)stats.p50Ms,
+               (unsigned long)stats.p90Ms, (unsigned long)stats.p99Ms, (unsigned long)stats.maxMs);
+    }
+  }
+}
+
+bool tracePost(HttpsSession& session, const char* url, size_t user, uint32_t at) {
+  char body[512];
+  size_t len = traceJson(windows[user], at, body, sizeof(body));
+  if (len >= sizeof(body) || !session.begin(url)) {
+    return false;
+  }
+  session.http().addHeader("Content-Type", "application/json");
+  int code = session.PUT(body, len);
+  session.end();
+  if (code < 200 || code >= 300) {
+    LOG_WARN("%s: odeslani latenci selhalo (HTTP %d)", ids[user], code);
+    return false;
+  }
+  return true;
+}
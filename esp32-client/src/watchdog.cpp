@@ -0,0 +1,37 @@
+#include "watchdog.h"
+
+#include <esp_task_wdt.h>
+#include "log.h"
+
+static bool watched = false; // feeding an unsubscribed task logs an error
+
+void watchdogBegin() {
+  // the core may have started the watchdog already (idle tasks); this
+  // only sets the timeout and the panic on expiry
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  esp_task_wdt_config_t config = {};
+  config.timeout_ms = WATCHDOG_TIMEOUT_S * 1000;
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU0
+  config.idle_core_mask |= 1 << 0; // keep the idle tasks the core watches
+#endif
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU1
+  config.idle_core_mask |= 1 << 1;
+#endif
+  config.trigger_panic = true;
+  if (esp_task_wdt_reconfigure(&config) != ESP_OK) { // not started by the core
+    esp_task_wdt_init(&config);
+  }
+#else
+  esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+#endif
+  watched = esp_task_wdt_add(nullptr) == ESP_OK;
+  if (!watched) {
+    LOG_WARN("Watchdog: pridani ulohy selhalo");
+  }
+}
+
+void watchdogFeed() {
+  if (watched) {
+    esp_task_wdt_reset();
+  }
+}
@@ -0,0 +1,292 @@
+#include "wifi_connect.h"
+
+#include <WiFi.h>
+#include <Preferences.h>
+#include <freertos/event_groups.h>
+#include "fnv1a.h"
+#include "log.h"
+#include "watchdog.h"
+
+static const unsigned long FAST_CONNECT_TIMEOUT_MS = 3000;
+static const unsigned long PER_NETWORK_TIMEOUT_MS = 8000;
+static const unsigned long SCAN_TIMEOUT_MS = 5000;
+static const size_t MAX_CANDIDATES = 8; // strongest known APs tried after a scan
+
+// Last AP that worked, stored as one NVS blob ("wifi"/"ap")
+struct WifiCache {
+  uint32_t ssidHash; // detects a reordered/changed creds[] list
+  uint8_t index;
+  uint8_t channel;
+  uint8_t bssid[6];
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t mask;
+  uint32_t dns;
+};
+
+// Link state, written by onWifiEvent() on the core's event task and read
+// by the network task
+static EventGroupHandle_t linkBits = nullptr;
+static const EventBits_t LINK_UP = 1 << 0;     // associated, with an IP
+static const EventBits_t LINK_FAILED = 1 << 1; // an attempt or the link failed
+static portMUX_TYPE linkLock = portMUX_INITIALIZER_UNLOCKED;
+static WifiLinkChange change; // newest, not taken yet
+static volatile bool changed = false;
+static unsigned long downSinceMs = 0;
+static uint8_t lastReason = 0;
+static uint8_t failures = 0; // attempts in a row on the current network
+static size_t current = 0;   // creds[] entry in use
+static const WifiCred* roamedTo = nullptr; // not in the NVS cache yet
+
+static bool loadCache(WifiCache& cache) {
+  Preferences prefs;
+  if (!prefs.begin("wifi", true)) {
+    return false;
+  }
+  size_t len = prefs.getBytes("ap", &cache, sizeof(cache));
+  prefs.end();
+  return len == sizeof(cache);
+}
+
+static void saveCache(size_t index, const WifiCred& cred) {
+  WifiCache cache = {};
+  cache.ssidHash = fnv1a(cred.ssid);
+  cache.index = (uint8_t)index;
+  cache.channel = (uint8_t)WiFi.channel();
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+#if WIFI_CACHE_IP
+  cache.ip = WiFi.localIP();
+  cache.gateway = WiFi.gatewayIP();
+  cache.mask = WiFi.subnetMask();
+  cache.dns = WiFi.dnsIP();
+#endif
+
+  WifiCache old;
+  if (loadCache(old) && memcmp(&old, &cache, sizeof(cache)) == 0) {
+    return; // unchanged, spare the flash
+  }
+  Preferences prefs;
+  if (prefs.begin("wifi", false)) {
+    prefs.putBytes("ap", &cache, sizeof(cache));
+    prefs.end();
+  }
+}
+
+static void clearCache() {
+  Preferences prefs;
+  if (prefs.begin("wifi", false)) {
+    prefs.remove("ap");
+    prefs.end();
+  }
+}
+
+// Runs on the core's event task: only bookkeeping, no WiFi calls
+static void onWifiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    portENTER_CRITICAL(&linkLock);
+    change = WifiLinkChange{ true, 0, millis() - downSinceMs };
+    changed = true;
+    failures = 0;
+    portEXIT_CRITICAL(&linkLock);
+    xEventGroupClearBits(linkBits, LINK_FAILED);
+    xEventGroupSetBits(linkBits, LINK_UP);
+  } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    uint8_t reason = info.wifi_sta_disconnected.reason;
+    bool own = reason == WIFI_REASON_ASSOC_LEAVE; // our disconnect() or a new begin()
+    bool wasUp = (xEventGroupGetBits(linkBits) & LINK_UP) != 0;
+    portENTER_CRITICAL(&linkLock);
+    if (wasUp) {
+      downSinceMs = millis();
+      change = WifiLinkChange{ false, reason, 0 };
+      changed = true;
+    }
+    if (!own) {
+      lastReason = reason;
+      failures = failures < UINT8_MAX ? failures + 1 : failures;
+    }
+    portEXIT_CRITICAL(&linkLock);
+    xEventGroupClearBits(linkBits, LINK_UP);
+    if (!own) {
+      xEventGroupSetBits(linkBits, LINK_FAILED);
+    }
+  }
+}
+
+static void watchLink() {
+  if (linkBits != nullptr) {
+    return;
+  }
+  linkBits = xEventGroupCreate();
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+}
+
+bool waitForWifi(unsigned long timeoutMs) {
+  EventBits_t bits = xEventGroupWaitBits(linkBits, LINK_UP, pdFALSE, pdFALSE, pdMS_TO_TICKS(timeoutMs));
+  return (bits & LINK_UP) != 0;
+}
+
+// Also returns as soon as the attempt fails (wrong password, AP gone)
+// instead of waiting out the timeout
+static bool tryConnect(const WifiCred& cred, int32_t channel, const uint8_t* bssid,
+                       unsigned long timeoutMs) {
+  watchdogFeed(); // a scan plus a few attempts can outlast the watchdog
+  LOG_INFO("Zkousim WiFi '%s' (kanal %d)...", cred.ssid, (int)channel);
+  xEventGroupClearBits(linkBits, LINK_FAILED);
+  WiFi.begin(cred.ssid, cred.pass, channel, bssid);
+  EventBits_t bits = xEventGroupWaitBits(linkBits, LINK_UP | LINK_FAILED, pdFALSE, pdFALSE,
+                                         pdMS_TO_TICKS(timeoutMs));
+  if (bits & LINK_UP) {
+    return true;
+  }
+  WiFi.disconnect();
+  return false;
+}
+
+static bool connected(size_t index, const WifiCred& cred) {
+  LOG_INFO("WiFi pripojeno ('%s'), IP: %s", cred.ssid, WiFi.localIP().toString().c_str());
+  saveCache(index, cred);
+  current = index;
+  roamedTo = nullptr;
+  return true;
+}
+
+// Reasons that another try on the same network won't fix soon
+static bool unreachable(uint8_t reason) {
+  switch (reason) {
+    case WIFI_REASON_NO_AP_FOUND:
+    case WIFI_REASON_AUTH_FAIL:
+    case WIFI_REASON_ASSOC_FAIL:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void wifiReconnect(const WifiCred* creds, size_t count) {
+  portENTER_CRITICAL(&linkLock);
+  uint8_t reason = lastReason;
+  bool roam = count > 1 && failures >= WIFI_ROAM_AFTER && unreachable(reason);
+  if (roam) {
+    failures = 0;
+  }
+  portEXIT_CRITICAL(&linkLock);
+  xEventGroupClearBits(linkBits, LINK_FAILED);
+  if (!roam) {
+    LOG_INFO("WiFi: znovu pripojuji (duvod %u)", (unsigned)reason);
+    WiFi.reconnect();
+    return;
+  }
+  size_t next = (current + 1) % count;
+  LOG_INFO("WiFi '%s' nedostupna (duvod %u), zkousim '%s'", creds[current].ssid, (unsigned)reason,
+           creds[next].ssid);
+  current = next;
+  roamedTo = &creds[current];
+  WiFi.begin(creds[current].ssid, creds[current].pass);
+}
+
+bool wifiTakeLinkChange(WifiLinkChange& out) {
+  portENTER_CRITICAL(&linkLock);
+  bool any = changed;
+  out = change;
+  changed = false;
+  portEXIT_CRITICAL(&linkLock);
+  if (any && out.up && roamedTo != nullptr) {
+    saveCache(current, *roamedTo);
+    roamedTo = nullptr;
+  }
+  return any;
+}
+
+bool wifiLinkChangePending() {
+  return changed;
+}
+
+bool wifiConnect(const WifiCred* creds, size_t count) {
+  WiFi.persistent(false); // the core would otherwise rewrite its own flash config on every begin()
+  WiFi.setAutoReconnect(false); // wifiReconnect() decides, see net_supervisor.h
+  watchLink();
+  WiFi.mode(WIFI_STA);
+
+  WifiCache cache;
+  if (loadCache(cache) && cache.index < count
+      && cache.ssidHash == fnv1a(creds[cache.index].ssid)) {
+#if WIFI_CACHE_IP
+    if (cache.ip != 0) {
+      WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.mask),
+                  IPAddress(cache.dns));
+    }
+#endif
+    if (tryConnect(creds[cache.index], cache.channel, cache.bssid, FAST_CONNECT_TIMEOUT_MS)) {
+      return connected(cache.index, creds[cache.index]);
+    }
+    LOG_INFO("Ulozena WiFi nedostupna, hledam site...");
+    clearCache();
+#if WIFI_CACHE_IP
+    // back to DHCP
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+#endif
+  }
+
+  // one scan for all known networks instead of a blind begin() per entry
+  WiFi.scanNetworks(true);
+  unsigned long scanStart = millis();
+  int16_t found;
+  while ((found = WiFi.scanComplete()) == WIFI_SCAN_RUNNING
+         && millis() - scanStart < SCAN_TIMEOUT_MS) {
+    delay(50);
+  }
+
+  // the APs of known networks, strongest first; copied out of the scan
+  // before the first begin(), which may invalidate the results
+  struct Candidate {
+    size_t cred;
+    int32_t rssi;
+    int32_t channel;
+    uint8_t bssid[6];
+  };
+  Candidate candidates[MAX_CANDIDATES];
+  size_t candidateCount = 0;
+  for (int16_t i = 0; i < found; ++i) {
+    String ssid = WiFi.SSID(i);
+    size_t c = 0;
+    while (c < count && !ssid.equals(creds[c].ssid)) {
+      ++c;
+    }
+    int32_t rssi = WiFi.RSSI(i);
+    if (c == count || (candidateCount == MAX_CANDIDATES && rssi <= candidates[candidateCount - 1].rssi)) {
+      continue;
+    }
+    size_t at = candidateCount < MAX_CANDIDATES ? candidateCount++ : MAX_CANDIDATES - 1;
+    for (; at > 0 && candidates[at - 1].rssi < rssi; --at) {
+      candidates[at] = candidates[at - 1];
+    }
+    candidates[at].cred = c;
+    candidates[at].rssi = rssi;
+    candidates[at].channel = WiFi.channel(i);
+    memcpy(candidates[at].bssid, WiFi.BSSID(i), sizeof(candidates[at].bssid));
+  }
+  WiFi.scanDelete();
+
+  bool sawKnown = candidateCount > 0;
+  for (size_t n = 0; n < candidateCount; ++n) {
+    const Candidate& cand = candidates[n];
+    if (tryConnect(creds[cand.cred], cand.channel, cand.bssid, PER_NETWORK_TIMEOUT_MS)) {
+      return connected(cand.cred, creds[cand.cred]);
+    }
+  }
+
+  if (!sawKnown) {
+    // scan failed or saw none of our SSIDs (e.g. hidden network): fall
+    // back to a plain begin() for each entry in order
+    for (size_t c = 0; c < count; ++c) {
+      if (tryConnect(creds[c], 0, nullptr, PER_NETWORK_TIMEOUT_MS)) {
+        return connected(c, creds[c]);
+      }
+    }
+  }
+  downSinceMs = millis();
+  return false;
+}
@@ -0,0 +1,142 @@
+// test/bench_workloads.h - benchmark workloads shared by the host and on-target suites
+#ifndef BENCH_WORKLOADS_H
+#define BENCH_WORKLOADS_H
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compact_reading.h"
+#include "glucose_alert.h"
+#include "glucose_frame.h"
+#include "glucose_history.h"
+#include "history_parser.h"
+#include "latest_json.h"
+#include "led_state.h"
+
+// Each workload does one operation per iteration and returns a checksum
+// of its results, so the compiler cannot drop the work.
+struct BenchWorkload {
+  const char* name;
+  uint32_t iterations; // on the host; the target suite divides these
+  uint32_t (*run)(uint32_t iterations);
+};
+
+// A latest.json as written by the ingestor (trimmed graph)
+static const char BENCH_LATEST_JSON[] =
+  "{\"fetched_at\":\"2024-11-10T20:39:01\",\"fetched_at_unix\":1731271141,"
+  "\"fetched_at_unix_ms\":1731271141000,\"main\":{\"glucose\":5.4,\"glucose_mgdl\":97,"
+  "\"time\":\"11/10/2024 9:38:31 PM\",\"timestamp\":1731271111.0,\"trend\":3,\"is_high\":false,"
+  "\"is_low\":false},\"graph\":[{\"v\":5.1,\"t\":1731270511},{\"v\":5.2,\"t\":1731270811}]}";
+
+static const char BENCH_COMPACT_BODY[] = "\"01000036673119C7\"";
+
+// A full day of history, {"<ts>": <mmol/L>, ...}, built by benchSetup()
+static char benchHistoryBody[GlucoseHistory::CAPACITY * 20 + 2];
+static size_t benchHistoryLen = 0;
+
+static GlucoseHistory benchHistory;
+
+static void benchSetup() {
+  size_t len = 0;
+  benchHistoryBody[len++] = '{';
+  for (size_t i = 0; i < GlucoseHistory::CAPACITY; ++i) {
+    unsigned tenths = 40 + (unsigned)(i * 7 % 120);
+    len += snprintf(benchHistoryBody + len, sizeof(benchHistoryBody) - len, "%s\"%lu\":%u.%u",
+                    i ? "," : "", (unsigned long)(1731200000UL + i * 300), tenths / 10, tenths % 10);
+  }
+  benchHistoryBody[len++] = '}';
+  benchHistoryLen = len;
+}
+
+static uint32_t benchRenderFrame(uint32_t iterations) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    DisplayFrame frame = glucoseFrame((uint16_t)(40 + i % 360), (Trend)(i % 6));
+    sum += frame.seg[0] ^ frame.seg[1] ^ frame.seg[2] ^ frame.seg[3];
+  }
+  return sum;
+}
+
+static uint32_t benchLedState(uint32_t iterations) {
+  uint32_t sum = 0;
+  AlertStatus alert{ false, true, false, 0 };
+  for (uint32_t i = 0; i < iterations; ++i) {
+    alert.predictedLow = (i & 1) != 0;
+    alert.stale = (i & 2) != 0;
+    LedState state = ledStateFor((uint16_t)(40 + i % 360), alert);
+    sum += (uint32_t)state.color + state.blinkMs;
+  }
+  return sum;
+}
+
+// What fetchGlucose() does per poll: filter, parse, pick the reading
+static uint32_t benchParseLatest(uint32_t iterations) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    StaticJsonDocument<LATEST_FILTER_CAPACITY> filter;
+    latestFilter(filter);
+    StaticJsonDocument<LATEST_DOC_CAPACITY> doc;
+    if (deserializeJson(doc, BENCH_LATEST_JSON, sizeof(BENCH_LATEST_JSON) - 1,
+                        DeserializationOption::Filter(filter))) {
+      continue;
+    }
+    GlucoseReading reading{ GLUCOSE_NONE, 0 };
+    uint32_t publishedAt = 0;
+    if (extractLatest(doc.as<JsonVariantConst>(), reading, publishedAt) == LatestStatus::Main) {
+      sum += reading.mgdl + reading.timestamp + publishedAt;
+    }
+  }
+  return sum;
+}
+
+static uint32_t benchDecodeCompact(uint32_t iterations) {
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    GlucoseReading reading{ GLUCOSE_NONE, 0 };
+    if (decodeCompactReading(BENCH_COMPACT_BODY, sizeof(BENCH_COMPACT_BODY) - 1, reading)) {
+      sum += reading.mgdl + reading.timestamp;
+    }
+  }
+  return sum;
+}
+
+// One iteration is a whole day of history (the boot-time backfill)
+static uint32_t benchParseHistory(uint32_t iterations) {
+  uint32_t sum = 0;
+  HistoryParser parser;
+  for (uint32_t i = 0; i < iterations; ++i) {
+    parser.reset();
+    for (size_t j = 0; j < benchHistoryLen; ++j) {
+      if (parser.feed(benchHistoryBody[j])) {
+        sum += parser.mgdl();
+      }
+    }
+  }
+  return sum;
+}
+
+// Per reading: append, then trend and low prediction as updateLeds() does
+static uint32_t benchHistoryAlert(uint32_t iterations) {
+  uint32_t sum = 0;
+  benchHistory.clear();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    uint32_t ts = 1731200000UL + i * 300;
+    benchHistory.add(ts, (uint16_t)(80 + (i * 13) % 100));
+    AlertStatus alert = evaluateAlert(benchHistory, ts + 60);
+    sum += (uint32_t)alert.predictedMgdl + (uint32_t)benchHistory.trend();
+  }
+  return sum;
+}
+
+static const BenchWorkload BENCH_WORKLOADS[] = {
+  { "render_frame", 1000000, benchRenderFrame },
+  { "led_state", 1000000, benchLedState },
+  { "parse_latest_json", 100000, benchParseLatest },
+  { "decode_compact", 1000000, benchDecodeCompact },
+  { "parse_history_day", 1000, benchParseHistory },
+  { "history_alert", 1000000, benchHistoryAlert },
+};
+static const size_t BENCH_WORKLOAD_COUNT = sizeof(BENCH_WORKLOADS) / sizeof(BENCH_WORKLOADS[0]);
+
+#endif // BENCH_WORKLOADS_H
@@ -0,0 +1,57 @@
+// test/embedded/test_bench/test_main.cpp - on-target cycle benchmark (pio test -e lolin_s2_mini -f embedded/test_bench)
+#include <Arduino.h>
+#include <unity.h>
+
+#include "../../bench_workloads.h"
+
+// The S2 is far slower than a host and has no FPU, so the host iteration
+// counts are scaled down to keep each workload around a second.
+#ifndef BENCH_TARGET_DIVISOR
+#define BENCH_TARGET_DIVISOR 100
+#endif
+
+static size_t current = 0;
+static volatile uint32_t sink = 0;
+
+void setUp() {}
+void tearDown() {}
+
+// CCOUNT counts CPU cycles and wraps every ~18 s at 240 MHz, so each
+// workload must stay well below that
+static void test_workload() {
+  const BenchWorkload& w = BENCH_WORKLOADS[current];
+  uint32_t iterations = w.iterations / BENCH_TARGET_DIVISOR;
+  if (iterations == 0) {
+    iterations = 1;
+  }
+  sink += w.run(iterations / 10 + 1); // fill the flash cache
+
+  uint32_t freeBefore = ESP.getFreeHeap();
+  uint32_t start = ESP.getCycleCount();
+  uint32_t checksum = w.run(iterations);
+  uint32_t cycles = ESP.getCycleCount() - start;
+  int32_t heapDelta = (int32_t)ESP.getFreeHeap() - (int32_t)freeBefore;
+  sink += checksum;
+
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  char line[112];
+  snprintf(line, sizeof(line), "%-18s %8lu cycles/op %8.2f us/op @ %lu MHz, heap %+ld", w.name,
+           (unsigned long)(cycles / iterations), (double)cycles / iterations / mhz, (unsigned long)mhz,
+           (long)heapDelta);
+  TEST_MESSAGE(line);
+
+  TEST_ASSERT_NOT_EQUAL(0, checksum);
+  TEST_ASSERT_EQUAL_INT32_MESSAGE(0, heapDelta, "heap changed on the per-reading path");
+}
+
+void setup() {
+  delay(2000); // give the host time to open the port
+  benchSetup();
+  UNITY_BEGIN();
+  for (current = 0; current < BENCH_WORKLOAD_COUNT; ++current) {
+    UnityDefaultTestRun(test_workload, BENCH_WORKLOADS[current].name, __LINE__);
+  }
+  UNITY_END();
+}
+
+void loop() {}
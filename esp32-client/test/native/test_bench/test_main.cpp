@@ -0,0 +1,71 @@
+// test/native/test_bench/test_main.cpp - host throughput and allocation benchmark (pio test -e native -v)
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "../../bench_workloads.h"
+
+// Every heap allocation through new counts. The per-reading path must not
+// allocate (the firmware runs for weeks on a fragmenting heap), so any
+// count other than zero fails the workload.
+static volatile uint32_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+void operator delete(void* p) noexcept {
+  free(p);
+}
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+static size_t current = 0;
+static volatile uint32_t sink = 0;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_workload() {
+  const BenchWorkload& w = BENCH_WORKLOADS[current];
+  sink += w.run(w.iterations / 100 + 1); // warm up caches and branch predictors
+
+  uint32_t allocationsBefore = allocations;
+  auto start = std::chrono::steady_clock::now();
+  uint32_t checksum = w.run(w.iterations);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  uint32_t allocated = allocations - allocationsBefore;
+  sink += checksum;
+
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() / w.iterations;
+  char line[96];
+  snprintf(line, sizeof(line), "%-18s %10.1f ns/op %12.0f ops/s %u allocs", w.name, ns, 1e9 / ns, allocated);
+  TEST_MESSAGE(line);
+
+  TEST_ASSERT_NOT_EQUAL(0, checksum);
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, allocated, "heap allocation on the per-reading path");
+}
+
+int main(int, char**) {
+  benchSetup();
+  UNITY_BEGIN();
+  for (current = 0; current < BENCH_WORKLOAD_COUNT; ++current) {
+    UnityDefaultTestRun(test_workload, BENCH_WORKLOADS[current].name, __LINE__);
+  }
+  return UNITY_END();
+}
@@ -0,0 +1,995 @@
+// test/native/test_core/test_main.cpp - unit tests for lib/glucose_core (pio test -e native)
+#include <ArduinoJson.h>
+#include <string.h>
+#include <unity.h>
+
+#include "compact_reading.h"
+#include "device_settings.h"
+#include "display_view.h"
+#include "fetch_scheduler.h"
+#include "fnv1a.h"
+#include "glucose_alert.h"
+#include "glucose_frame.h"
+#include "glucose_history.h"
+#include "hmac_sha256.h"
+#include "history_parser.h"
+#include "latency_histogram.h"
+#include "latest_json.h"
+#include "net_supervisor.h"
+#include "led_state.h"
+#include "ota_manifest.h"
+#include "peer_packet.h"
+#include "reading_cache.h"
+#include "reading_trace.h"
+
+// The frame tests assume the default config (mmol/L with a trend arrow)
+static_assert(CONFIG.unit == GlucoseUnit::MmolL, "test_core expects the default GLUCOSE_UNIT");
+static_assert(CONFIG.display == DisplayMode::ValueTrend, "test_core expects the default GLUCOSE_DISPLAY_MODE");
+
+static const uint32_t T0 = 1700000000; // any plausible sensor time
+static const uint32_t CGM_STEP_S = 300;
+// FRAME_COLON as it lands in the frame: the point segment of digit 1
+static const uint8_t COLON_SEG = 0x80;
+
+void setUp() {}
+void tearDown() {}
+
+static void assertFrame(const DisplayFrame& frame, uint8_t s0, uint8_t s1, uint8_t s2, uint8_t s3) {
+  const uint8_t expected[4] = { s0, s1, s2, s3 };
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, frame.seg, 4);
+}
+
+// Fills the trend window with readings stepMgdl apart, one CGM period each
+static void fillHistory(GlucoseHistory& history, uint16_t first, int stepMgdl) {
+  for (size_t i = 0; i < GlucoseHistory::TREND_WINDOW; ++i) {
+    history.add(T0 + i * CGM_STEP_S, (uint16_t)(first + (int)i * stepMgdl));
+  }
+}
+
+// --- conversions ---
+
+static void test_mmol_mgdl_round_trip() {
+  TEST_ASSERT_EQUAL_UINT16(97, tenthsToMgdl(54));
+  TEST_ASSERT_EQUAL_UINT16(54, mgdlToTenths(97));
+  // every tenth on the display survives the trip through mg/dL
+  for (uint16_t tenths = 10; tenths <= 300; ++tenths) {
+    TEST_ASSERT_EQUAL_UINT16(tenths, mgdlToTenths(tenthsToMgdl(tenths)));
+  }
+  TEST_ASSERT_EQUAL_UINT16(GLUCOSE_NONE, mmolToMgdl(0.0f));
+  TEST_ASSERT_EQUAL_UINT16(97, mmolToMgdl(5.4f));
+}
+
+static void test_parse_mmol() {
+  uint16_t mgdl = 0;
+  TEST_ASSERT_TRUE(parseMmol("5.4", 3, mgdl));
+  TEST_ASSERT_EQUAL_UINT16(centiMmolToMgdl(540), mgdl);
+  TEST_ASSERT_TRUE(parseMmol("7.25", 4, mgdl));
+  TEST_ASSERT_EQUAL_UINT16(centiMmolToMgdl(725), mgdl);
+  TEST_ASSERT_TRUE(parseMmol("12", 2, mgdl));
+  TEST_ASSERT_EQUAL_UINT16(centiMmolToMgdl(1200), mgdl);
+  TEST_ASSERT_TRUE(parseMmol("6.1234", 6, mgdl)); // extra decimals are truncated
+  TEST_ASSERT_EQUAL_UINT16(centiMmolToMgdl(612), mgdl);
+
+  TEST_ASSERT_FALSE(parseMmol("", 0, mgdl));
+  TEST_ASSERT_FALSE(parseMmol(".", 1, mgdl));
+  TEST_ASSERT_FALSE(parseMmol("-1.0", 4, mgdl));
+  TEST_ASSERT_FALSE(parseMmol("5.4e0", 5, mgdl));
+  TEST_ASSERT_FALSE(parseMmol("1.2.3", 5, mgdl));
+  TEST_ASSERT_FALSE(parseMmol("1000", 4, mgdl));
+  TEST_ASSERT_TRUE(parseMmol("999", 3, mgdl));
+}
+
+// --- display frames ---
+
+static void test_frame_mmol() {
+  // " 5:40" with the colon on the second digit and a flat arrow in front
+  assertFrame(glucoseFrame(tenthsToMgdl(54)), 0, DIGIT_SEGMENTS[5] | COLON_SEG, DIGIT_SEGMENTS[4],
+              DIGIT_SEGMENTS[0]);
+  assertFrame(glucoseFrame(tenthsToMgdl(123)), DIGIT_SEGMENTS[1], DIGIT_SEGMENTS[2] | COLON_SEG,
+              DIGIT_SEGMENTS[3], DIGIT_SEGMENTS[0]);
+}
+
+static void test_frame_none_and_overflow() {
+  assertFrame(glucoseFrame(GLUCOSE_NONE), 0, COLON_SEG, 0, DIGIT_SEGMENTS[0]);
+  // 100.0 mmol/L needs five digits
+  DisplayFrame overflow = glucoseFrame(tenthsToMgdl(1000));
+  assertFrame(overflow, DIGIT_SEGMENTS[9], DIGIT_SEGMENTS[9], DIGIT_SEGMENTS[9], DIGIT_SEGMENTS[9]);
+}
+
+static void test_frame_trend() {
+  uint16_t mgdl = tenthsToMgdl(54);
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SEG_G, glucoseFrame(mgdl, Trend::Flat).seg[0]);
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SEG_A, glucoseFrame(mgdl, Trend::Rising).seg[0]);
+  TEST_ASSERT_EQUAL_HEX8(FRAME_SEG_D | FRAME_SEG_C | FRAME_SEG_E, glucoseFrame(mgdl, Trend::FallingFast).seg[0]);
+  TEST_ASSERT_EQUAL_HEX8(0, glucoseFrame(mgdl, Trend::Unknown).seg[0]);
+  // no room for the arrow in front of a two-digit value, and no arrow without a value
+  TEST_ASSERT_EQUAL_HEX8(DIGIT_SEGMENTS[1], glucoseFrame(tenthsToMgdl(123), Trend::Flat).seg[0]);
+  TEST_ASSERT_EQUAL_HEX8(0, glucoseFrame(GLUCOSE_NONE, Trend::Flat).seg[0]);
+}
+
+static void test_number_frame_leading_zero() {
+  assertFrame(numberFrame(42, 0, true), DIGIT_SEGMENTS[0], DIGIT_SEGMENTS[0], DIGIT_SEGMENTS[4], DIGIT_SEGMENTS[2]);
+  assertFrame(numberFrame(42, 0, false), 0, 0, DIGIT_SEGMENTS[4], DIGIT_SEGMENTS[2]);
+}
+
+static void test_user_label_frame() {
+  const uint8_t U = FRAME_SEG_B | FRAME_SEG_C | FRAME_SEG_D | FRAME_SEG_E | FRAME_SEG_F;
+  assertFrame(userLabelFrame(1), U, 0, 0, DIGIT_SEGMENTS[1]);
+  assertFrame(userLabelFrame(9), U, 0, 0, DIGIT_SEGMENTS[9]);
+}
+
+// --- LEDs ---
+
+static void test_led_thresholds() {
+  TEST_ASSERT_EQUAL(LedColor::Off, ledColorFor(GLUCOSE_NONE));
+  TEST_ASSERT_EQUAL(LedColor::Red, ledColorFor(CONFIG.lowMgdl - 1));
+  TEST_ASSERT_EQUAL(LedColor::Green, ledColorFor(CONFIG.lowMgdl));
+  TEST_ASSERT_EQUAL(LedColor::Green, ledColorFor(CONFIG.highMgdl));
+  TEST_ASSERT_EQUAL(LedColor::Yellow, ledColorFor(CONFIG.highMgdl + 1));
+}
+
+static void test_led_state() {
+  AlertStatus none{ false, false, false, 0 };
+  AlertStatus stale{ true, false, false, 0 };
+  AlertStatus low{ false, true, true, 50 };
+
+  TEST_ASSERT_TRUE((LedState{ LedColor::Green, 0, false }) == ledStateFor(100, none));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Green, LED_STALE_BLINK_MS, false }) == ledStateFor(100, stale));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Red, CONFIG.blinkMs, false }) == ledStateFor(100, low));
+  // already red: a predicted low adds nothing
+  TEST_ASSERT_TRUE((LedState{ LedColor::Red, 0, false }) == ledStateFor(60, low));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Off, 0, false }) == ledStateFor(GLUCOSE_NONE, low));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Red, LED_URGENT_BLINK_MS, false }) == ledStateFor(CONFIG.urgentLowMgdl - 1, none));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Red, LED_URGENT_BLINK_MS, false }) == ledStateFor(CONFIG.urgentLowMgdl - 1, stale));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Yellow, LED_HIGH_FADE_MS, true }) == ledStateFor(250, none));
+  TEST_ASSERT_TRUE((LedState{ LedColor::Yellow, LED_STALE_BLINK_MS, false }) == ledStateFor(250, stale));
+}
+
+static void test_worse_led_state() {
+  const LedState off{ LedColor::Off, 0, false };
+  const LedState green{ LedColor::Green, 0, false };
+  const LedState greenStale{ LedColor::Green, LED_STALE_BLINK_MS, false };
+  const LedState yellow{ LedColor::Yellow, 0, false };
+  const LedState red{ LedColor::Red, 0, false };
+  const LedState redAlarm{ LedColor::Red, CONFIG.blinkMs, false };
+  const LedState redStale{ LedColor::Red, LED_STALE_BLINK_MS, false };
+
+  TEST_ASSERT_TRUE(green == worseLedState(off, green));
+  TEST_ASSERT_TRUE(yellow == worseLedState(greenStale, yellow));
+  TEST_ASSERT_TRUE(red == worseLedState(yellow, red));
+  TEST_ASSERT_TRUE(redAlarm == worseLedState(red, redAlarm));
+  TEST_ASSERT_TRUE(greenStale == worseLedState(greenStale, green));
+  // the faster blink (alarm) outranks the slow stale blink
+  TEST_ASSERT_TRUE(redAlarm == worseLedState(redStale, redAlarm));
+  TEST_ASSERT_TRUE(redAlarm == worseLedState(redAlarm, redStale));
+  // same speed: the blink outranks the fade
+  const LedState yellowFade{ LedColor::Yellow, LED_STALE_BLINK_MS, true };
+  const LedState yellowStale{ LedColor::Yellow, LED_STALE_BLINK_MS, false };
+  TEST_ASSERT_TRUE(yellowStale == worseLedState(yellowFade, yellowStale));
+  TEST_ASSERT_TRUE(yellowStale == worseLedState(yellowStale, yellowFade));
+}
+
+static void test_led_pattern_level() {
+  const LedState steady{ LedColor::Green, 0, false };
+  const LedState blink{ LedColor::Red, 100, false };
+  const LedState fade{ LedColor::Yellow, 100, true };
+
+  TEST_ASSERT_EQUAL_UINT8(0, ledPatternLevel(LedState{ LedColor::Off, 100, false }, 0));
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(steady, 12345));
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(blink, 0));
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(blink, 99));
+  TEST_ASSERT_EQUAL_UINT8(0, ledPatternLevel(blink, 100));
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(blink, 200));
+  // triangle: full, off at the half period, full again
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(fade, 0));
+  TEST_ASSERT_EQUAL_UINT8(127, ledPatternLevel(fade, 50));
+  TEST_ASSERT_EQUAL_UINT8(0, ledPatternLevel(fade, 100));
+  TEST_ASSERT_EQUAL_UINT8(127, ledPatternLevel(fade, 150));
+  TEST_ASSERT_EQUAL_UINT8(LED_LEVEL_FULL, ledPatternLevel(fade, 200));
+}
+
+static void test_led_brightness_at_night() {
+  TEST_ASSERT_EQUAL_UINT8(100, ledBrightnessAt(-1));
+  TEST_ASSERT_EQUAL_UINT8(100, ledBrightnessAt(12));
+  TEST_ASSERT_EQUAL_UINT8(100, ledBrightnessAt(CONFIG.nightFromH - 1));
+  TEST_ASSERT_EQUAL_UINT8(CONFIG.nightBrightness, ledBrightnessAt(CONFIG.nightFromH));
+  TEST_ASSERT_EQUAL_UINT8(CONFIG.nightBrightness, ledBrightnessAt(0));
+  TEST_ASSERT_EQUAL_UINT8(CONFIG.nightBrightness, ledBrightnessAt(CONFIG.nightToH - 1));
+  TEST_ASSERT_EQUAL_UINT8(100, ledBrightnessAt(CONFIG.nightToH));
+}
+
+// --- history, trend and prediction ---
+
+static void test_history_order_and_capacity() {
+  static GlucoseHistory history;
+  history.clear();
+  TEST_ASSERT_TRUE(history.add(T0, 100));
+  TEST_ASSERT_FALSE(history.add(T0, 101));     // duplicate
+  TEST_ASSERT_FALSE(history.add(T0 - 1, 101)); // older
+  TEST_ASSERT_EQUAL_UINT32(1, history.size());
+
+  const size_t extra = 12;
+  for (size_t i = 1; i < GlucoseHistory::CAPACITY + extra; ++i) {
+    history.add(T0 + i * CGM_STEP_S, 100);
+  }
+  TEST_ASSERT_EQUAL_UINT32(GlucoseHistory::CAPACITY, history.size());
+  TEST_ASSERT_EQUAL_UINT32(T0 + extra * CGM_STEP_S, history.at(0).timestamp);
+  TEST_ASSERT_EQUAL_UINT32(T0 + (GlucoseHistory::CAPACITY + extra - 1) * CGM_STEP_S, history.latest().timestamp);
+}
+
+static void test_trend() {
+  static GlucoseHistory history;
+  history.clear();
+  history.add(T0, 100);
+  TEST_ASSERT_EQUAL(Trend::Unknown, history.trend());
+
+  // mg/dL per 5 minutes: -15 = -3/min, -7 = -1.4/min, ...
+  const struct {
+    int step;
+    Trend trend;
+  } cases[] = {
+    { -15, Trend::FallingFast }, { -7, Trend::Falling }, { 0, Trend::Flat },
+    { 3, Trend::Flat },          { 8, Trend::Rising },   { 15, Trend::RisingFast },
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    history.clear();
+    fillHistory(history, 150, cases[i].step);
+    TEST_ASSERT_EQUAL(cases[i].trend, history.trend());
+  }
+}
+
+static void test_predict() {
+  static GlucoseHistory history;
+  history.clear();
+  TEST_ASSERT_EQUAL_INT32(0, history.predict(T0));
+  history.add(T0, 120);
+  TEST_ASSERT_EQUAL_INT32(120, history.predict(T0 + 600));
+
+  history.clear();
+  fillHistory(history, 120, -15); // 120 105 90 75, -3 mg/dL per minute
+  uint32_t latest = history.latest().timestamp;
+  TEST_ASSERT_EQUAL_INT32(75, history.predict(latest));
+  TEST_ASSERT_EQUAL_INT32(15, history.predict(latest + 20 * 60));
+
+  // only the trend window counts: an old outlier has dropped out
+  history.clear();
+  history.add(T0 - CGM_STEP_S, 300);
+  fillHistory(history, 100, 0);
+  TEST_ASSERT_EQUAL_INT32(100, history.predict(history.latest().timestamp + 3600));
+}
+
+static void test_alert() {
+  static GlucoseHistory history;
+  history.clear();
+  AlertStatus status = evaluateAlert(history, T0);
+  TEST_ASSERT_FALSE(status.stale);
+  TEST_ASSERT_FALSE(status.predicted);
+
+  fillHistory(history, 120, -15);
+  uint32_t latest = history.latest().timestamp;
+  status = evaluateAlert(history, latest);
+  TEST_ASSERT_FALSE(status.stale);
+  TEST_ASSERT_TRUE(status.predicted);
+  TEST_ASSERT_TRUE(status.predictedLow);
+  TEST_ASSERT_EQUAL_INT32(75 - 3 * ALERT_HORIZON_MIN, status.predictedMgdl);
+
+  // an unsynced clock means "no age", not "very old"
+  TEST_ASSERT_FALSE(evaluateAlert(history, 0).stale);
+
+  status = evaluateAlert(history, latest + ALERT_STALE_AFTER_S + 1);
+  TEST_ASSERT_TRUE(status.stale);
+  TEST_ASSERT_TRUE(status.predicted);
+  status = evaluateAlert(history, latest + ALERT_PREDICT_MAX_AGE_S + 1);
+  TEST_ASSERT_TRUE(status.stale);
+  TEST_ASSERT_FALSE(status.predicted);
+
+  history.clear();
+  fillHistory(history, 120, 0);
+  status = evaluateAlert(history, history.latest().timestamp);
+  TEST_ASSERT_TRUE(status.predicted);
+  TEST_ASSERT_FALSE(status.predictedLow);
+}
+
+// --- parsers ---
+
+static void test_history_parser() {
+  const char body[] = "{\"1700000000\": 5.4, \"1700000300\":6.1,\"bad\":7,"
+                      "\"1700000600\":{\"x\":[1,2]},\"1700000900\":\"5.0\",\"1700001200\":null,"
+                      "\"1700001210\":0,\"1700001220\":0.0,\r\n\"1700001500\":7.25}";
+  const uint32_t timestamps[] = { 1700000000, 1700000300, 1700001500 };
+  const uint16_t values[] = { centiMmolToMgdl(540), centiMmolToMgdl(610), centiMmolToMgdl(725) };
+
+  HistoryParser parser;
+  size_t n = 0;
+  for (const char* p = body; *p; ++p) {
+    if (parser.feed(*p)) {
+      TEST_ASSERT_LESS_THAN_UINT32(3, n);
+      TEST_ASSERT_EQUAL_UINT32(timestamps[n], parser.timestamp());
+      TEST_ASSERT_EQUAL_UINT16(values[n], parser.mgdl());
+      n++;
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, n);
+
+  n = 0;
+  parser.reset();
+  for (const char* p = "null"; *p; ++p) {
+    n += parser.feed(*p);
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, n);
+}
+
+static void test_compact_reading() {
+  GlucoseReading reading{ GLUCOSE_NONE, 0 };
+  const char* body = "\"01000036673119C7\"";
+  TEST_ASSERT_TRUE(decodeCompactReading(body, strlen(body), reading));
+  TEST_ASSERT_EQUAL_UINT16(tenthsToMgdl(54), reading.mgdl);
+  TEST_ASSERT_EQUAL_UINT32(0x673119C7, reading.timestamp);
+
+  body = "\"01000036673119c7\"";
+  TEST_ASSERT_TRUE(decodeCompactReading(body, strlen(body), reading));
+
+  const char* invalid[] = {
+    "null",
+    "\"02000036673119C7\"", // unknown version
+    "\"0100003667 319C7\"",
+    "\"01000036673119C7",
+    "\"01000036673119C700\"",
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    TEST_ASSERT_FALSE_MESSAGE(decodeCompactReading(invalid[i], strlen(invalid[i]), reading), invalid[i]);
+  }
+}
+
+static LatestStatus parseLatest(const char* json, GlucoseReading& reading, uint32_t& publishedAt) {
+  StaticJsonDocument<LATEST_FILTER_CAPACITY> filter;
+  latestFilter(filter);
+  TEST_ASSERT_FALSE(filter.overflowed());
+  StaticJsonDocument<LATEST_DOC_CAPACITY> doc;
+  DeserializationError err = deserializeJson(doc, json, DeserializationOption::Filter(filter));
+  TEST_ASSERT_EQUAL_STRING("Ok", err.c_str());
+  TEST_ASSERT_FALSE(doc.overflowed());
+  return extractLatest(doc.as<JsonVariantConst>(), reading, publishedAt);
+}
+
+static void test_extract_latest() {
+  GlucoseReading reading{ GLUCOSE_NONE, 0 };
+  uint32_t publishedAt = 0;
+
+  LatestStatus status = parseLatest("{\"fetched_at\":\"2024-11-10T20:39:01\",\"fetched_at_unix_ms\":1731271141000,"
+                                    "\"main\":{\"glucose\":5.4,\"time\":\"2024-11-10T20:38:31\","
+                                    "\"timestamp\":1731271111.0,\"trend\":3},\"graph\":[{\"v\":5.1},{\"v\":5.2}]}",
+                                    reading, publishedAt);
+  TEST_ASSERT_EQUAL(LatestStatus::Main, status);
+  TEST_ASSERT_EQUAL_UINT16(97, reading.mgdl);
+  TEST_ASSERT_EQUAL_UINT32(1731271111, reading.timestamp);
+  TEST_ASSERT_EQUAL_UINT32(1731271141, publishedAt);
+
+  status = parseLatest("{\"main\":{\"time\":\"2024-11-10T20:38:31\"}}", reading, publishedAt);
+  TEST_ASSERT_EQUAL(LatestStatus::NoGlucoseInMain, status);
+  TEST_ASSERT_EQUAL_UINT32(0, publishedAt);
+
+  status = parseLatest("{\"glucose\":6.1}", reading, publishedAt);
+  TEST_ASSERT_EQUAL(LatestStatus::TopLevel, status);
+  TEST_ASSERT_EQUAL_UINT16(mmolToMgdl(6.1f), reading.mgdl);
+  TEST_ASSERT_EQUAL_UINT32(0, reading.timestamp);
+
+  TEST_ASSERT_EQUAL(LatestStatus::NoGlucose, parseLatest("{}", reading, publishedAt));
+  TEST_ASSERT_EQUAL(LatestStatus::NoGlucose, parseLatest("null", reading, publishedAt));
+}
+
+static bool parseManifest(const char* json, OtaManifest& manifest) {
+  StaticJsonDocument<OTA_MANIFEST_DOC_CAPACITY> doc;
+  if (deserializeJson(doc, json)) {
+    return false;
+  }
+  return parseOtaManifest(doc.as<JsonVariantConst>(), manifest);
+}
+
+static void test_ota_manifest() {
+  OtaManifest manifest;
+  TEST_ASSERT_TRUE(parseManifest("{\"version\":7,\"size\":1043216,\"md5\":\"9e107d9d372bb6826bd81d3542a419d6\","
+                                 "\"url\":\"https://example.com/firmware-7.bin.gz\"}", manifest));
+  TEST_ASSERT_EQUAL_UINT32(7, manifest.version);
+  TEST_ASSERT_EQUAL_UINT32(1043216, manifest.size);
+  TEST_ASSERT_EQUAL_STRING("9e107d9d372bb6826bd81d3542a419d6", manifest.md5);
+  TEST_ASSERT_EQUAL_STRING("https://example.com/firmware-7.bin.gz", manifest.url);
+
+  // missing size, short md5, plain http
+  TEST_ASSERT_FALSE(parseManifest("{\"version\":7,\"md5\":\"9e107d9d372bb6826bd81d3542a419d6\","
+                                  "\"url\":\"https://example.com/f.bin\"}", manifest));
+  TEST_ASSERT_FALSE(parseManifest("{\"version\":7,\"size\":10,\"md5\":\"9e107d9d\","
+                                  "\"url\":\"https://example.com/f.bin\"}", manifest));
+  TEST_ASSERT_FALSE(parseManifest("{\"version\":7,\"size\":10,\"md5\":\"9e107d9d372bb6826bd81d3542a419d6\","
+                                  "\"url\":\"http://example.com/f.bin\"}", manifest));
+  TEST_ASSERT_FALSE(parseManifest("null", manifest));
+}
+
+static void test_gzip_header() {
+  // gzip -n: no name, no mtime
+  const uint8_t plain[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 2, 3, 0xed, 0x5d };
+  TEST_ASSERT_EQUAL(10, gzipHeaderSize(plain, sizeof(plain)));
+  TEST_ASSERT_EQUAL(0, gzipHeaderSize(plain, 9));
+  TEST_ASSERT_EQUAL(0, gzipHeaderSize(plain, 0));
+
+  // FEXTRA (2 bytes) + FNAME "fw" + FHCRC
+  const uint8_t flagged[] = { 0x1f, 0x8b, 8, 0x0e, 0, 0, 0, 0, 0, 3, 2, 0, 'x', 'y', 'f', 'w', 0, 0xaa, 0xbb, 0xed };
+  TEST_ASSERT_EQUAL(19, gzipHeaderSize(flagged, sizeof(flagged)));
+  TEST_ASSERT_EQUAL(0, gzipHeaderSize(flagged, 15)); // inside the name
+
+  // a raw image (ESP32 images start with 0xe9), not deflate, reserved flag
+  const uint8_t image[] = { 0xe9, 0x05, 0x02, 0x20 };
+  TEST_ASSERT_EQUAL(-1, gzipHeaderSize(image, sizeof(image)));
+  const uint8_t stored[] = { 0x1f, 0x8b, 0 };
+  TEST_ASSERT_EQUAL(-1, gzipHeaderSize(stored, sizeof(stored)));
+  const uint8_t reserved[] = { 0x1f, 0x8b, 8, 0x20 };
+  TEST_ASSERT_EQUAL(-1, gzipHeaderSize(reserved, sizeof(reserved)));
+}
+
+// --- scheduling and metrics ---
+
+static void test_scheduler_reading() {
+  FetchScheduler scheduler(60000);
+  // published 30 s after the sensor reading: next poll one period plus
+  // latency plus margin after the reading
+  TEST_ASSERT_EQUAL_UINT32(310000, scheduler.onReading(T0, T0 + 30, T0 + 30));
+  TEST_ASSERT_EQUAL_UINT32(30, scheduler.latencyS());
+
+  // a slightly shorter gap pulls the period estimate down
+  scheduler.onReading(T0 + 290, T0 + 320, T0 + 320);
+  TEST_ASSERT_EQUAL_UINT32(298, scheduler.periodS());
+  // a skipped reading does not
+  scheduler.onReading(T0 + 890, T0 + 920, T0 + 920);
+  TEST_ASSERT_EQUAL_UINT32(298, scheduler.periodS());
+
+  // polled late: never less than the minimum delay (the 300 s gap moves
+  // the period to 299 s)
+  TEST_ASSERT_EQUAL_UINT32(FetchScheduler::MIN_DELAY_MS, scheduler.onReading(T0 + 1190, T0 + 1220, T0 + 2000));
+  TEST_ASSERT_EQUAL_UINT32(299, scheduler.periodS());
+  // no clock: one period plus margin from now
+  TEST_ASSERT_EQUAL_UINT32((299 + FETCH_MARGIN_S) * 1000, scheduler.onReading(T0 + 1489, T0 + 1519, 0));
+}
+
+static void test_scheduler_unchanged_and_errors() {
+  FetchScheduler scheduler(60000);
+  scheduler.onReading(T0, T0 + 30, T0 + 30);
+  TEST_ASSERT_EQUAL_UINT32(15000, scheduler.onReading(T0, T0 + 30, T0 + 320)); // same reading
+  TEST_ASSERT_EQUAL_UINT32(30000, scheduler.onUnchanged());
+  TEST_ASSERT_EQUAL_UINT32(60000, scheduler.onUnchanged());
+  TEST_ASSERT_EQUAL_UINT32(60000, scheduler.onUnchanged()); // capped at the fallback interval
+
+  TEST_ASSERT_EQUAL_UINT32(2500, scheduler.onError(0));
+  TEST_ASSERT_EQUAL_UINT32(5000, scheduler.onError(UINT32_MAX - (UINT32_MAX % 5001))); // 10 s window, no jitter
+  for (int i = 0; i < 20; ++i) {
+    scheduler.onError(0);
+  }
+  uint32_t delay = scheduler.onError(UINT32_MAX);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(FetchScheduler::MAX_BACKOFF_MS / 2, delay);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(FetchScheduler::MAX_BACKOFF_MS, delay);
+
+  // a new reading resets both back-offs
+  scheduler.onReading(T0 + 300, T0 + 330, T0 + 330);
+  TEST_ASSERT_EQUAL_UINT32(15000, scheduler.onUnchanged());
+}
+
+static void test_latency_histogram() {
+  LatencyHistogram histogram;
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.percentileUs(50));
+  TEST_ASSERT_EQUAL_UINT32(0, histogram.minUs());
+
+  histogram.add(500);     // < 1 ms
+  histogram.add(1500);    // [1, 2) ms
+  histogram.add(3000);    // [2, 4) ms
+  histogram.add(3500);    // [2, 4) ms
+  histogram.add(UINT32_MAX);
+  TEST_ASSERT_EQUAL_UINT32(5, histogram.count());
+  TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(0));
+  TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(1));
+  TEST_ASSERT_EQUAL_UINT32(2, histogram.bucket(2));
+  TEST_ASSERT_EQUAL_UINT32(1, histogram.bucket(LatencyHistogram::BUCKETS - 1));
+  TEST_ASSERT_EQUAL_UINT32(500, histogram.minUs());
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, histogram.maxUs());
+
+  TEST_ASSERT_EQUAL_UINT32(1000, histogram.percentileUs(20));
+  TEST_ASSERT_EQUAL_UINT32(4000, histogram.percentileUs(50));
+  TEST_ASSERT_EQUAL_UINT32(4000, histogram.percentileUs(80));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, histogram.percentileUs(100));
+
+  // a percentile never exceeds the largest sample
+  histogram.clear();
+  histogram.add(1200);
+  TEST_ASSERT_EQUAL_UINT32(1200, histogram.percentileUs(99));
+}
+
+// --- settings ---
+
+static void test_settings_commands() {
+  static DeviceSettings settings;
+  settingsClear(settings);
+
+  TEST_ASSERT_EQUAL(SettingsCommand::None, settingsCommand(settings, "metrics"));
+  TEST_ASSERT_EQUAL(SettingsCommand::None, settingsCommand(settings, ""));
+  TEST_ASSERT_EQUAL(SettingsCommand::Show, settingsCommand(settings, "config"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Save, settingsCommand(settings, " save "));
+
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "wifi add Home secret123"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "wifi add \"Cafe Free\""));
+  TEST_ASSERT_EQUAL(2, settings.wifiCount);
+  TEST_ASSERT_EQUAL_STRING("Cafe Free", settings.wifi[1].ssid);
+  TEST_ASSERT_EQUAL_STRING("", settings.wifi[1].pass);
+  // a known SSID only gets the new password
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "wifi add Home \"new pass\""));
+  TEST_ASSERT_EQUAL(2, settings.wifiCount);
+  TEST_ASSERT_EQUAL_STRING("new pass", settings.wifi[0].pass);
+
+  TEST_ASSERT_EQUAL(SettingsCommand::Invalid, settingsCommand(settings, "wifi add \"unterminated"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Invalid, settingsCommand(settings, "wifi add a b c"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Invalid, settingsCommand(settings, "wifi del 3"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "wifi del 1"));
+  TEST_ASSERT_EQUAL(1, settings.wifiCount);
+  TEST_ASSERT_EQUAL_STRING("Cafe Free", settings.wifi[0].ssid);
+
+  TEST_ASSERT_EQUAL(SettingsCommand::Invalid, settingsCommand(settings, "url http://example.com"));
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "url https://db.example.com/"));
+  TEST_ASSERT_EQUAL_STRING("https://db.example.com", settings.rtdbUrl);
+  TEST_ASSERT_EQUAL(SettingsCommand::Changed, settingsCommand(settings, "token s3cret"));
+  TEST_ASSERT_EQUAL_STRING("s3cret", settings.pushToken);
+  TEST_ASSERT_TRUE(settingsValid(settings));
+}
+
+static void test_settings_limits() {
+  static DeviceSettings settings;
+  settingsClear(settings);
+  TEST_ASSERT_FALSE(settingsValid(settings)); // no RTDB url yet
+  TEST_ASSERT_TRUE(settingsSetUrl(settings, "https://db.example.com"));
+
+  char ssid[] = "net0";
+  for (size_t i = 0; i < SETTINGS_WIFI_MAX; ++i) {
+    ssid[3] = (char)('0' + i);
+    TEST_ASSERT_TRUE(settingsAddWifi(settings, ssid, "password"));
+  }
+  TEST_ASSERT_FALSE(settingsAddWifi(settings, "one-too-many", "password"));
+  TEST_ASSERT_TRUE(settingsAddWifi(settings, "net0", "changed")); // still replaceable
+
+  char longSsid[SETTINGS_SSID_SIZE + 1];
+  memset(longSsid, 'x', SETTINGS_SSID_SIZE);
+  longSsid[SETTINGS_SSID_SIZE] = '\0';
+  TEST_ASSERT_TRUE(settingsRemoveWifi(settings, 0));
+  TEST_ASSERT_FALSE(settingsAddWifi(settings, longSsid, ""));
+  TEST_ASSERT_TRUE(settingsValid(settings));
+
+  // a blob of another layout or with a broken string is not used
+  settings.layout = SETTINGS_LAYOUT + 1;
+  TEST_ASSERT_FALSE(settingsValid(settings));
+  settings.layout = SETTINGS_LAYOUT;
+  memset(settings.pushToken, 'x', SETTINGS_TOKEN_SIZE);
+  TEST_ASSERT_FALSE(settingsValid(settings));
+}
+
+// --- network supervisor ---
+
+static void test_net_supervisor_reconnect_backoff() {
+  NetSupervisor supervisor(1000);
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(2000, true));
+  // the link drops: one reconnect at once, then not on every pass but
+  // with a doubling gap
+  TEST_ASSERT_EQUAL(NetAction::Reconnect, supervisor.poll(3000, false));
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(3001, false));
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(3000 + NET_RECONNECT_MIN_S * 1000 - 1, false));
+  uint32_t t = 3000 + NET_RECONNECT_MIN_S * 1000;
+  TEST_ASSERT_EQUAL(NetAction::Reconnect, supervisor.poll(t, false));
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(t + NET_RECONNECT_MIN_S * 1000, false));
+  TEST_ASSERT_EQUAL(NetAction::Reconnect, supervisor.poll(t + 2 * NET_RECONNECT_MIN_S * 1000, false));
+  supervisor.onSuccess(t + 2 * NET_RECONNECT_MIN_S * 1000);
+
+  // back up, down again: the backoff starts over
+  t += 3 * NET_RECONNECT_MIN_S * 1000;
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(t, true));
+  TEST_ASSERT_EQUAL(NetAction::Reconnect, supervisor.poll(t, false));
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(t + NET_RECONNECT_MIN_S * 1000 - 1, false));
+  TEST_ASSERT_EQUAL(NetAction::Reconnect, supervisor.poll(t + NET_RECONNECT_MIN_S * 1000, false));
+
+  // the gap saturates
+  uint32_t gaps = 0;
+  for (uint32_t ms = t + NET_RECONNECT_MIN_S * 1000; ms < t + 9 * 60000UL; ms += 1000) {
+    supervisor.onSuccess(ms); // keep the escalation out of it
+    gaps += supervisor.poll(ms, false) == NetAction::Reconnect ? 1 : 0;
+  }
+  TEST_ASSERT_TRUE(gaps >= 4 && gaps <= 10);
+}
+
+static void test_net_supervisor_escalation() {
+  const uint32_t min = 60000UL;
+  NetSupervisor supervisor(0);
+  // associated, but fetches fail: WiFi restart first, then a reboot
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(NET_RESTART_WIFI_MIN * min - 1, true));
+  TEST_ASSERT_EQUAL(NetAction::RestartWifi, supervisor.poll(NET_RESTART_WIFI_MIN * min, true));
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(NET_RESTART_WIFI_MIN * min + 1000, true));
+  TEST_ASSERT_EQUAL(NetAction::Reboot, supervisor.poll(NET_REBOOT_MIN * min, true));
+
+  // a success resets the escalation
+  supervisor.onSuccess(NET_REBOOT_MIN * min);
+  TEST_ASSERT_EQUAL(NetAction::None, supervisor.poll(NET_REBOOT_MIN * min + 1000, true));
+  TEST_ASSERT_EQUAL(2 * min, supervisor.quietMs(NET_REBOOT_MIN * min + 2 * min));
+
+  // no network in reach: WiFi restarts each period, never a reboot
+  NetSupervisor offline(0);
+  uint32_t restarts = 0;
+  for (uint32_t ms = 0; ms <= 2 * NET_REBOOT_MIN * min; ms += 1000) {
+    NetAction action = offline.poll(ms, false);
+    TEST_ASSERT_TRUE(action != NetAction::Reboot);
+    restarts += action == NetAction::RestartWifi ? 1 : 0;
+  }
+  TEST_ASSERT_EQUAL_UINT32(2 * NET_REBOOT_MIN / NET_RESTART_WIFI_MIN, restarts);
+}
+
+// --- reading cache ---
+
+static void test_reading_cache_round_trip() {
+  static GlucoseHistory history;
+  static GlucoseHistory restored;
+  static ReadingCache cache;
+  history.clear();
+  for (uint32_t i = 0; i < READING_CACHE_ENTRIES + 10; ++i) {
+    history.add(1700000000 + i * 300, (uint16_t)(100 + i));
+  }
+  uint32_t owner = readingCacheOwner("78347");
+  readingCacheStore(cache, owner, history);
+  TEST_ASSERT_EQUAL_UINT32(1700000000 + (READING_CACHE_ENTRIES + 9) * 300, readingCacheNewest(cache, owner));
+
+  restored.add(1, 1); // replaced, not appended to
+  TEST_ASSERT_TRUE(readingCacheRestore(cache, owner, restored));
+  TEST_ASSERT_EQUAL_UINT32(READING_CACHE_ENTRIES, restored.size());
+  TEST_ASSERT_EQUAL_UINT32(history.latest().timestamp, restored.latest().timestamp);
+  TEST_ASSERT_EQUAL_UINT16(history.latest().mgdl, restored.latest().mgdl);
+  TEST_ASSERT_EQUAL_UINT16(110, restored.at(0).mgdl); // the newest entries
+  TEST_ASSERT_EQUAL(history.trend(), restored.trend());
+}
+
+static void test_reading_cache_rejects() {
+  static GlucoseHistory history;
+  static ReadingCache cache;
+  history.clear();
+  history.add(1700000000, 120);
+  history.add(1700000300, 125);
+  uint32_t owner = readingCacheOwner("78347");
+  readingCacheStore(cache, owner, history);
+
+  // another user's cache, e.g. after GLUCOSE_USERS changed
+  TEST_ASSERT_FALSE(readingCacheRestore(cache, readingCacheOwner("12345"), history));
+  TEST_ASSERT_EQUAL_UINT32(0, readingCacheNewest(cache, readingCacheOwner("12345")));
+
+  // memory that was never written or got torn
+  cache.mgdl[1] ^= 1;
+  TEST_ASSERT_FALSE(readingCacheRestore(cache, owner, history));
+  TEST_ASSERT_EQUAL_UINT32(2, history.size()); // left alone
+  memset(&cache, 0xa5, sizeof(cache));
+  TEST_ASSERT_FALSE(readingCacheRestore(cache, owner, history));
+
+  // nothing to show
+  history.clear();
+  readingCacheStore(cache, owner, history);
+  TEST_ASSERT_FALSE(readingCacheRestore(cache, owner, history));
+  TEST_ASSERT_EQUAL_UINT32(0, readingCacheNewest(cache, owner));
+}
+
+static void test_fnv1a() {
+  TEST_ASSERT_EQUAL_HEX32(0x811c9dc5, fnv1a(""));
+  TEST_ASSERT_EQUAL_HEX32(0xe40c292c, fnv1a("a"));
+  TEST_ASSERT_EQUAL_HEX32(0xbf9cf968, fnv1a("foobar"));
+  TEST_ASSERT_EQUAL_HEX32(fnv1a("78347"), readingCacheOwner("78347"));
+}
+
+// --- peer packets ---
+
+static const char PEER_KEY[] = "shared-token";
+
+// RFC 4231 test cases 1, 2 and 6 (a key longer than a block)
+static void test_hmac_sha256() {
+  uint8_t key[20];
+  memset(key, 0x0b, sizeof(key));
+  const char* data = "Hi There";
+  const uint8_t expect1[SHA256_SIZE] = {
+    0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf, 0xce, 0xaf, 0x0b, 0xf1, 0x2b,
+    0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7, 0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7,
+  };
+  uint8_t mac[SHA256_SIZE];
+  hmacSha256(key, sizeof(key), (const uint8_t*)data, strlen(data), mac);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expect1, mac, SHA256_SIZE);
+
+  data = "what do ya want for nothing?";
+  const uint8_t expect2[SHA256_SIZE] = {
+    0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+    0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83, 0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43,
+  };
+  hmacSha256((const uint8_t*)"Jefe", 4, (const uint8_t*)data, strlen(data), mac);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expect2, mac, SHA256_SIZE);
+  TEST_ASSERT_TRUE(macEqual(expect2, mac, SHA256_SIZE));
+
+  uint8_t longKey[131];
+  memset(longKey, 0xaa, sizeof(longKey));
+  data = "Test Using Larger Than Block-Size Key - Hash Key First";
+  const uint8_t expect6[SHA256_SIZE] = {
+    0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa, 0xcb, 0xf5, 0xb7, 0x7f,
+    0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14, 0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54,
+  };
+  hmacSha256(longKey, sizeof(longKey), (const uint8_t*)data, strlen(data), mac);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(expect6, mac, SHA256_SIZE);
+  mac[31] ^= 1;
+  TEST_ASSERT_FALSE(macEqual(expect2, mac, SHA256_SIZE));
+}
+
+static PeerPacket peerReading(uint32_t sender, uint32_t epoch, uint32_t seq) {
+  PeerPacket packet{};
+  packet.type = PeerType::Reading;
+  packet.sender = sender;
+  packet.epoch = epoch;
+  packet.seq = seq;
+  packet.sentAt = T0 + 40;
+  strcpy(packet.uid, "78347");
+  packet.reading = GlucoseReading{ tenthsToMgdl(54), T0 };
+  packet.publishedAt = T0 + 30;
+  return packet;
+}
+
+static void test_peer_packet_round_trip() {
+  uint8_t buf[PEER_PACKET_MAX];
+  PeerPacket sent = peerReading(0x01020304, 7, 42);
+  size_t len = encodePeerPacket(sent, PEER_KEY, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_UINT32(PEER_HEADER_SIZE + 11 + 5 + PEER_MAC_SIZE, len);
+  TEST_ASSERT_EQUAL_HEX8('G', buf[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, buf[4]); // big-endian sender
+
+  PeerPacket got;
+  TEST_ASSERT_TRUE(decodePeerPacket(buf, len, PEER_KEY, got));
+  TEST_ASSERT_EQUAL(PeerType::Reading, got.type);
+  TEST_ASSERT_EQUAL_UINT32(0x01020304, got.sender);
+  TEST_ASSERT_EQUAL_UINT32(7, got.epoch);
+  TEST_ASSERT_EQUAL_UINT32(42, got.seq);
+  TEST_ASSERT_EQUAL_UINT32(T0 + 40, got.sentAt);
+  TEST_ASSERT_EQUAL_STRING("78347", got.uid);
+  TEST_ASSERT_EQUAL_UINT16(tenthsToMgdl(54), got.reading.mgdl);
+  TEST_ASSERT_EQUAL_UINT32(T0, got.reading.timestamp);
+  TEST_ASSERT_EQUAL_UINT32(T0 + 30, got.publishedAt);
+
+  PeerPacket hello{};
+  hello.type = PeerType::Hello;
+  TEST_ASSERT_EQUAL_UINT32(PEER_HEADER_SIZE + PEER_MAC_SIZE,
+                           encodePeerPacket(hello, PEER_KEY, buf, sizeof(buf)));
+  TEST_ASSERT_TRUE(decodePeerPacket(buf, PEER_HEADER_SIZE + PEER_MAC_SIZE, PEER_KEY, got));
+  TEST_ASSERT_EQUAL(PeerType::Hello, got.type);
+}
+
+static void test_peer_packet_invalid() {
+  uint8_t buf[PEER_PACKET_MAX + 1];
+  PeerPacket packet = peerReading(1, 1, 1);
+  size_t len = encodePeerPacket(packet, PEER_KEY, buf, sizeof(buf));
+  PeerPacket got;
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len - 1, PEER_KEY, got)); // truncated
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, 10, PEER_KEY, got));
+  buf[len] = 0;
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len + 1, PEER_KEY, got)); // trailing byte
+  buf[2] = PEER_VERSION + 1;
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+  buf[2] = PEER_VERSION;
+  buf[3] = 9; // unknown type
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+
+  TEST_ASSERT_EQUAL_UINT32(0, encodePeerPacket(packet, PEER_KEY, buf, PEER_HEADER_SIZE)); // too small
+  memset(packet.uid, 'x', sizeof(packet.uid)); // unterminated
+  TEST_ASSERT_EQUAL_UINT32(0, encodePeerPacket(packet, PEER_KEY, buf, sizeof(buf)));
+}
+
+static void test_peer_packet_forged() {
+  uint8_t buf[PEER_PACKET_MAX];
+  PeerPacket packet = peerReading(1, 1, 1);
+  PeerPacket got;
+  // a host without the token signs with a key of its own
+  size_t len = encodePeerPacket(packet, "guess", buf, sizeof(buf));
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+  len = encodePeerPacket(packet, "", buf, sizeof(buf));
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+
+  // a genuine packet with its value rewritten, or its MAC damaged
+  len = encodePeerPacket(packet, PEER_KEY, buf, sizeof(buf));
+  buf[21] ^= 0x40;
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+  buf[21] ^= 0x40;
+  buf[len - 1] ^= 1;
+  TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+  buf[len - 1] ^= 1;
+  TEST_ASSERT_TRUE(decodePeerPacket(buf, len, PEER_KEY, got));
+
+  // signed, but not a reading a CGM reports
+  const uint16_t implausible[] = { 0, PEER_MIN_MGDL - 1, PEER_MAX_MGDL + 1, 0xffff };
+  for (uint16_t mgdl : implausible) {
+    packet.reading.mgdl = mgdl;
+    len = encodePeerPacket(packet, PEER_KEY, buf, sizeof(buf));
+    TEST_ASSERT_FALSE(decodePeerPacket(buf, len, PEER_KEY, got));
+  }
+  packet.reading.mgdl = PEER_MAX_MGDL;
+  len = encodePeerPacket(packet, PEER_KEY, buf, sizeof(buf));
+  TEST_ASSERT_TRUE(decodePeerPacket(buf, len, PEER_KEY, got));
+}
+
+static void test_peer_table_sequence() {
+  PeerTable table(100);
+  TEST_ASSERT_FALSE(table.accept(peerReading(100, 1, 1), 0)); // our own, looped back
+  TEST_ASSERT_TRUE(table.accept(peerReading(200, 1, 5), 0));
+  TEST_ASSERT_FALSE(table.accept(peerReading(200, 1, 5), 10)); // duplicate
+  TEST_ASSERT_FALSE(table.accept(peerReading(200, 1, 4), 20)); // reordered
+  TEST_ASSERT_TRUE(table.accept(peerReading(200, 1, 6), 30));
+  TEST_ASSERT_TRUE(table.accept(peerReading(200, 2, 1), 40)); // rebooted
+  TEST_ASSERT_TRUE(table.accept(peerReading(300, 9, 1), 50));
+  TEST_ASSERT_EQUAL_UINT32(2, table.alive(50));
+}
+
+static void test_peer_table_leader() {
+  PeerTable table(200);
+  TEST_ASSERT_TRUE(table.isLeader(0)); // alone
+  table.accept(peerReading(300, 1, 1), 0);
+  TEST_ASSERT_TRUE(table.isLeader(0));
+  table.accept(peerReading(100, 1, 1), 1000);
+  TEST_ASSERT_FALSE(table.isLeader(1000));
+  TEST_ASSERT_FALSE(table.isLeader(1000 + PeerTable::TIMEOUT_MS - 1));
+  // the lower id went quiet: take over
+  TEST_ASSERT_TRUE(table.isLeader(1000 + PeerTable::TIMEOUT_MS));
+  TEST_ASSERT_EQUAL_UINT32(0, table.alive(1000 + PeerTable::TIMEOUT_MS));
+}
+
+static void test_display_view_sparkline() {
+  static GlucoseHistory history;
+  static Sparkline spark;
+  history.clear();
+  sparklineFrom(history, spark);
+  for (size_t i = 0; i < SPARKLINE_POINTS; ++i) {
+    TEST_ASSERT_EQUAL_UINT8(SPARKLINE_GAP, spark.level[i]);
+  }
+
+  // two hours more than the line holds, with a missed reading
+  const uint32_t readings = SPARKLINE_POINTS + 24;
+  for (uint32_t i = 0; i < readings; ++i) {
+    if (i != readings - 3) {
+      history.add(T0 + i * CGM_STEP_S + (i % 2) * 20, (uint16_t)(60 + i)); // jittered
+    }
+  }
+  sparklineFrom(history, spark);
+  TEST_ASSERT_EQUAL_UINT8(sparklineLevel(60 + readings - 1), spark.level[SPARKLINE_POINTS - 1]);
+  TEST_ASSERT_EQUAL_UINT8(SPARKLINE_GAP, spark.level[SPARKLINE_POINTS - 3]);
+  TEST_ASSERT_EQUAL_UINT8(sparklineLevel(60 + readings - SPARKLINE_POINTS), spark.level[0]);
+
+  TEST_ASSERT_EQUAL_UINT8(1, sparklineLevel(20));
+  TEST_ASSERT_EQUAL_UINT8(1, sparklineLevel(SPARKLINE_MIN_MGDL));
+  TEST_ASSERT_EQUAL_UINT8(SPARKLINE_TOP, sparklineLevel(SPARKLINE_MAX_MGDL));
+  TEST_ASSERT_TRUE(sparklineLevel(CONFIG.lowMgdl) < sparklineLevel(CONFIG.highMgdl));
+}
+
+static void test_display_view_dirty() {
+  DisplayView shown = displayView(tenthsToMgdl(54), Trend::Flat, true);
+  DisplayView next = shown;
+  TEST_ASSERT_EQUAL_UINT8(0, displayDirty(shown, next));
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(glucoseFrame(tenthsToMgdl(54), Trend::Flat).seg, shown.frame.seg, 4);
+
+  next.stale = false;
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_REGION_STALE, displayDirty(shown, next));
+  next = displayView(tenthsToMgdl(61), Trend::Rising, true);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_REGION_VALUE | DISPLAY_REGION_TREND, displayDirty(shown, next));
+  next = shown;
+  next.spark.level[SPARKLINE_POINTS - 1] = sparklineLevel(next.mgdl);
+  TEST_ASSERT_EQUAL_UINT8(DISPLAY_REGION_SPARKLINE, displayDirty(shown, next));
+}
+
+static void test_glucose_text() {
+  char text[8];
+  TEST_ASSERT_EQUAL_UINT32(3, glucoseText(text, sizeof(text), tenthsToMgdl(54)));
+  TEST_ASSERT_EQUAL_STRING("5.4", text);
+  glucoseText(text, sizeof(text), tenthsToMgdl(120));
+  TEST_ASSERT_EQUAL_STRING("12.0", text);
+  glucoseText(text, sizeof(text), GLUCOSE_NONE);
+  TEST_ASSERT_EQUAL_STRING("---", text);
+  TEST_ASSERT_EQUAL_UINT32(4, glucoseText(text, 3, tenthsToMgdl(120))); // cut, like snprintf
+  TEST_ASSERT_EQUAL_STRING("12", text);
+}
+
+static void test_reading_trace_stages() {
+  ReadingTrace trace = { T0, T0 + 150, (uint64_t)(T0 + 152) * 1000 + 250, 40, TraceSource::Poll };
+  TEST_ASSERT_EQUAL_UINT32(150000, traceStageMs(trace, TraceStage::Publish));
+  TEST_ASSERT_EQUAL_UINT32(2250, traceStageMs(trace, TraceStage::Deliver));
+  TEST_ASSERT_EQUAL_UINT32(152250, traceStageMs(trace, TraceStage::Receive));
+  TEST_ASSERT_EQUAL_UINT32(40, traceStageMs(trace, TraceStage::Display));
+  TEST_ASSERT_EQUAL_UINT32(152290, traceStageMs(trace, TraceStage::Total));
+
+  // stream: no publication time; not shown yet
+  trace.publishedAt = 0;
+  trace.displayMs = TRACE_NONE;
+  TEST_ASSERT_EQUAL_UINT32(TRACE_NONE, traceStageMs(trace, TraceStage::Publish));
+  TEST_ASSERT_EQUAL_UINT32(TRACE_NONE, traceStageMs(trace, TraceStage::Deliver));
+  TEST_ASSERT_EQUAL_UINT32(TRACE_NONE, traceStageMs(trace, TraceStage::Total));
+  TEST_ASSERT_EQUAL_UINT32(152250, traceStageMs(trace, TraceStage::Receive));
+
+  // device clock behind the sensor's
+  trace.receivedAtMs = (uint64_t)(T0 - 3) * 1000;
+  TEST_ASSERT_EQUAL_UINT32(0, traceStageMs(trace, TraceStage::Receive));
+}
+
+static void test_reading_trace_percentiles() {
+  static TraceWindow window;
+  TraceStats empty = window.stats(TraceStage::Receive);
+  TEST_ASSERT_EQUAL_UINT16(0, empty.count);
+  TEST_ASSERT_EQUAL_UINT32(0, empty.p50Ms);
+
+  // TRACE_WINDOW + 10 readings, receive = i s; every 4th pushed
+  for (uint32_t i = 1; i <= TRACE_WINDOW + 10; ++i) {
+    ReadingTrace trace = { T0, 0, (uint64_t)(T0 + i) * 1000, 10, i % 4 == 0 ? TraceSource::Push : TraceSource::Poll };
+    window.add(trace);
+  }
+  TEST_ASSERT_EQUAL_UINT32(TRACE_WINDOW, window.size());
+  TraceStats all = window.stats(TraceStage::Receive);
+  TEST_ASSERT_EQUAL_UINT16(TRACE_WINDOW, all.count);
+  // the oldest readings are gone: 11 .. TRACE_WINDOW + 10 s
+  TEST_ASSERT_EQUAL_UINT32((10 + (TRACE_WINDOW + 1) / 2) * 1000, all.p50Ms);
+  TEST_ASSERT_EQUAL_UINT32((10 + (TRACE_WINDOW * 90 + 99) / 100) * 1000, all.p90Ms);
+  TEST_ASSERT_EQUAL_UINT32((TRACE_WINDOW + 10) * 1000, all.maxMs);
+  TEST_ASSERT_EQUAL_UINT16(0, window.stats(TraceStage::Deliver).count);
+
+  TraceStats pushed = window.stats(TraceStage::Receive, TraceSource::Push);
+  TEST_ASSERT_EQUAL_UINT16(TRACE_WINDOW / 4, pushed.count);
+  TEST_ASSERT_EQUAL_UINT32(0, pushed.maxMs % 4000);
+
+  char json[512];
+  size_t len = traceJson(window, T0, json, sizeof(json));
+  TEST_ASSERT_EQUAL_UINT32(strlen(json), len);
+  TEST_ASSERT_TRUE(strstr(json, ",\"display\":{\"n\":48,\"p50\":10,") != nullptr);
+  TEST_ASSERT_EQUAL_UINT32(len, traceJson(window, T0, json, 16)); // cut, like snprintf
+  TEST_ASSERT_EQUAL_UINT32(15, strlen(json));
+
+  window.clear();
+  TEST_ASSERT_EQUAL_UINT32(0, window.size());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_mmol_mgdl_round_trip);
+  RUN_TEST(test_parse_mmol);
+  RUN_TEST(test_frame_mmol);
+  RUN_TEST(test_frame_none_and_overflow);
+  RUN_TEST(test_frame_trend);
+  RUN_TEST(test_number_frame_leading_zero);
+  RUN_TEST(test_led_thresholds);
+  RUN_TEST(test_user_label_frame);
+  RUN_TEST(test_led_state);
+  RUN_TEST(test_worse_led_state);
+  RUN_TEST(test_led_pattern_level);
+  RUN_TEST(test_led_brightness_at_night);
+  RUN_TEST(test_history_order_and_capacity);
+  RUN_TEST(test_trend);
+  RUN_TEST(test_predict);
+  RUN_TEST(test_alert);
+  RUN_TEST(test_history_parser);
+  RUN_TEST(test_compact_reading);
+  RUN_TEST(test_extract_latest);
+  RUN_TEST(test_ota_manifest);
+  RUN_TEST(test_settings_commands);
+  RUN_TEST(test_settings_limits);
+  RUN_TEST(test_gzip_header);
+  RUN_TEST(test_scheduler_reading);
+  RUN_TEST(test_scheduler_unchanged_and_errors);
+  RUN_TEST(test_latency_histogram);
+  RUN_TEST(test_net_supervisor_reconnect_backoff);
+  RUN_TEST(test_net_supervisor_escalation);
+  RUN_TEST(test_reading_cache_round_trip);
+  RUN_TEST(test_reading_cache_rejects);
+  RUN_TEST(test_fnv1a);
+  RUN_TEST(test_peer_packet_round_trip);
+  RUN_TEST(test_peer_packet_invalid);
+  RUN_TEST(test_peer_packet_forged);
+  RUN_TEST(test_hmac_sha256);
+  RUN_TEST(test_peer_table_sequence);
+  RUN_TEST(test_peer_table_leader);
+  RUN_TEST(test_display_view_sparkline);
+  RUN_TEST(test_display_view_dirty);
+  RUN_TEST(test_glucose_text);
+  RUN_TEST(test_reading_trace_stages);
+  RUN_TEST(test_reading_trace_percentiles);
+  return UNITY_END();
+}
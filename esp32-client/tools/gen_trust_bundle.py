@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Generate src/rtdb_trust.cpp, the pinned trust anchors for the RTDB host.
+
+The output is an ESP-IDF x509_crt_bundle (the format esp_crt_bundle_attach()
+and WiFiClientSecure::setCACertBundle() read): a big-endian u16 count, then
+per root CA a u16 subject length, a u16 public key length, the DER subject
+and the DER SubjectPublicKeyInfo, sorted by subject. Only the subject and
+the key of each root are stored, so nothing has to be parsed at handshake
+time.
+
+Usage (needs openssl on PATH):
+    tools/gen_trust_bundle.py /etc/ssl/certs/GTS_Root_R1.pem ... > src/rtdb_trust.cpp
+"""
+
+import os
+import subprocess
+import sys
+
+
+def run_openssl(args, data=None):
+    return subprocess.run(["openssl"] + args, input=data, capture_output=True, check=True).stdout
+
+
+def read_tlv(data, offset):
+    """Return (tag, header length, value length) of the DER element at offset."""
+    tag = data[offset]
+    length = data[offset + 1]
+    header = 2
+    if length & 0x80:
+        size = length & 0x7F
+        length = int.from_bytes(data[offset + 2:offset + 2 + size], "big")
+        header += size
+    return tag, header, length
+
+
+def subject_der(cert):
+    """Return the raw DER subject Name of a DER certificate."""
+    _, header, _ = read_tlv(cert, 0)  # Certificate
+    offset = header
+    _, header, _ = read_tlv(cert, offset)  # tbsCertificate
+    offset += header
+    tag, header, length = read_tlv(cert, offset)
+    if tag == 0xA0:  # explicit version
+        offset += header + length
+    for _ in range(4):  # serial, signature, issuer, validity
+        _, header, length = read_tlv(cert, offset)
+        offset += header + length
+    _, header, length = read_tlv(cert, offset)
+    return cert[offset:offset + header + length]
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+
+    entries = []
+    for path in sys.argv[1:]:
+        cert = run_openssl(["x509", "-in", path, "-outform", "DER"])
+        pem_key = run_openssl(["x509", "-in", path, "-pubkey", "-noout"])
+        key = run_openssl(["pkey", "-pubin", "-outform", "DER"], pem_key)
+        name = os.path.splitext(os.path.basename(path))[0].replace("_", " ")
+        entries.append((subject_der(cert), key, name))
+    entries.sort(key=lambda entry: entry[0])
+
+    bundle = bytearray(len(entries).to_bytes(2, "big"))
+    for subject, key, _ in entries:
+        bundle += len(subject).to_bytes(2, "big") + len(key).to_bytes(2, "big") + subject + key
+
+    names = ", ".join(entry[2] for entry in entries)
+    print("// Generated by tools/gen_trust_bundle.py - do not edit by hand.")
+    print(f"// Roots: {names}")
+    print('#include "rtdb_trust.h"')
+    print()
+    print("const uint8_t RTDB_CA_BUNDLE[] = {")
+    for i in range(0, len(bundle), 16):
+        print("  " + ", ".join(f"0x{b:02x}" for b in bundle[i:i + 16]) + ",")
+    print("};")
+    print("const size_t RTDB_CA_BUNDLE_SIZE = sizeof(RTDB_CA_BUNDLE);")
+
+
+if __name__ == "__main__":
+    main()
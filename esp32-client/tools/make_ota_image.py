@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""
+Compress a firmware image for OTA and print its manifest.
+
+Writes <image>.gz next to the image (gzip -9, no name or timestamp in the
+header, so the same image always gives the same file) and prints the JSON
+manifest the device reads from firmware/<OTA_CHANNEL>.json in RTDB (see
+lib/glucose_core/src/ota_manifest.h). size and md5 are of the uncompressed
+image, which the device verifies after inflating it into flash.
+
+Usage:
+    pio run -e lolin_s2_mini   # built with -DGLUCOSE_OTA=1 -DFIRMWARE_VERSION=<n>
+    tools/make_ota_image.py .pio/build/lolin_s2_mini/firmware.bin <n> <url of the .gz>
+
+Upload the .gz to the url (e.g. Firebase Storage), then put the manifest
+into RTDB under firmware/<OTA_CHANNEL>.
+"""
+
+import gzip
+import hashlib
+import json
+import sys
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    path, version, url = sys.argv[1], int(sys.argv[2]), sys.argv[3]
+    if not url.startswith("https://"):
+        sys.exit("the device only downloads over https")
+
+    with open(path, "rb") as f:
+        image = f.read()
+    if not image or image[0] != 0xE9:
+        sys.exit(f"{path} is not an ESP32 app image")
+
+    packed = gzip.compress(image, compresslevel=9, mtime=0)
+    with open(path + ".gz", "wb") as f:
+        f.write(packed)
+
+    print(f"{path}.gz: {len(packed)} of {len(image)} B ({100 * len(packed) // len(image)} %)", file=sys.stderr)
+    print(json.dumps({
+        "version": version,
+        "size": len(image),
+        "md5": hashlib.md5(image).hexdigest(),
+        "url": url,
+    }, indent=2))
+
+
+if __name__ == "__main__":
+    main()
@@ -512,6 +512,12 @@ def save_to_firestore(uid: str, data: Dict[str, Any]) -> None:
         raise
 
 
+# main.timestamp of the last reading written to users/{uid}/latest. The
+# devices poll latest with If-None-Match; rewriting an unchanged reading
+# with fresh fetched_at* fields would change its ETag every cycle.
+last_latest_timestamp = None
+
+
 def save_to_realtime_db(uid: str, data: Dict[str, Any]) -> None:
     """
     Save monitor status data to Firebase Realtime Database.
@@ -534,6 +540,137 @@ def save_to_realtime_db(uid: str, data: Dict[str, Any]) -> None:
         raise
 
 
+# Realtime Database history: users/{uid}/history/{unix_ts} = glucose (mmol/L).
+# Devices backfill their trend buffer from it after a reboot with one
+# orderBy="$key"&limitToLast=N query.
+HISTORY_RETENTION_HOURS = 26  # a bit more than the device's 24 h buffer
+last_history_ts: Dict[str, int] = {}
+
+
+def save_history_to_realtime_db(uid: str, status_data: Dict[str, Any]) -> None:
+    """
+    Write new glucose readings to Realtime Database history and prune old ones.
+
+    Only readings newer than the last one written by this process are sent, so
+    after a restart the whole EasyView window is (re)written once and later
+    iterations add just the new points in a single multi-path update.
+
+    Args:
+        uid: User UID (will be converted to string if needed)
+        status_data: Status data dictionary from get_status()
+    """
+    uid_str = str(uid)
+
+    try:
+        sg_data = status_data.get('data', {}).get('chart', {}).get('sg', []) or []
+        cutoff = int(time.time()) - HISTORY_RETENTION_HOURS * 3600
+        since = max(last_history_ts.get(uid_str, 0), cutoff)
+
+        updates = {}
+        for item in sg_data:
+            ts = int(float(item[0]))
+            glucose = item[1]
+            if ts > since and isinstance(glucose, (int, float)) and not math.isnan(glucose):
+                updates[str(ts)] = round(glucose, 1)
+
+        ref = db.reference(f"users/{uid_str}/history")
+        if updates:
+            ref.update(updates)
+            last_history_ts[uid_str] = max(int(k) for k in updates)
+            logger.info(f"Saved {len(updates)} readings to Realtime Database: users/{uid_str}/history")
+
+        # Numeric keys sort numerically, so everything up to the cutoff is old
+        old = ref.order_by_key().end_at(str(cutoff)).limit_to_first(500).get() or {}
+        if old:
+            ref.update({key: None for key in old})
+            logger.debug(f"Pruned {len(old)} old readings from users/{uid_str}/history")
+    except Exception as e:
+        logger.error(f"Failed to save history to Realtime Database: {e}", exc_info=True)
+        raise
+
+
+# Realtime Database compact record: users/{uid}/compact = "<16 hex digits>".
+# An 8-byte big-endian record for microcontroller clients, which only need
+# one value and its timestamp (the firmware's GLUCOSE_COMPACT decoder):
+#   u8 version (1), u8 flags (0), u16 glucose in 0.1 mmol/L, u32 unix ts
+# RTDB only stores JSON, so the record is hex-encoded as a JSON string;
+# the REST body is 18 bytes instead of a ~200 byte object.
+COMPACT_VERSION = 1
+
+
+def encode_compact_reading(values: Dict[str, Any]) -> str:
+    """
+    Encode a reading from get_values() as the compact record.
+
+    Args:
+        values: Dictionary with glucose (mmol/L) and timestamp (unix s)
+
+    Returns:
+        The 8-byte record as 16 uppercase hex digits
+    """
+    tenths = int(round(float(values["glucose"]) * 10))
+    tenths = max(0, min(tenths, 0xFFFF))
+    ts = int(float(values["timestamp"])) & 0xFFFFFFFF
+    record = bytes([COMPACT_VERSION, 0]) + tenths.to_bytes(2, "big") + ts.to_bytes(4, "big")
+    return record.hex().upper()
+
+
+def save_compact_to_realtime_db(uid: str, values: Dict[str, Any]) -> None:
+    """
+    Save the latest reading to Realtime Database as the compact record.
+
+    Args:
+        uid: User UID (will be converted to string if needed)
+        values: Dictionary with glucose and timestamp from get_values()
+    """
+    uid_str = str(uid)
+
+    try:
+        record = encode_compact_reading(values)
+        db.reference(f"users/{uid_str}/compact").set(record)
+        logger.debug(f"Data saved to Realtime Database: users/{uid_str}/compact = {record}")
+    except Exception as e:
+        logger.error(f"Failed to save compact record to Realtime Database: {e}", exc_info=True)
+        raise
+
+
+# LAN push: POST the compact record straight to displays on the local
+# network (firmware built with GLUCOSE_LAN_PUSH), ahead of the cloud writes.
+# The devices keep polling Firebase as a fallback, so failures only log.
+LAN_PUSH_URLS = [u.strip() for u in os.getenv("LAN_PUSH_URLS", "").split(",") if u.strip()]
+LAN_PUSH_TOKEN = os.getenv("LAN_PUSH_TOKEN", "")
+LAN_PUSH_TIMEOUT_S = 2
+
+
+def push_compact_to_lan(uid: str, values: Dict[str, Any]) -> None:
+    """
+    Push the latest reading as the compact record to every LAN_PUSH_URLS device.
+
+    Args:
+        uid: User UID the reading belongs to
+        values: Dictionary with glucose and timestamp from get_values()
+    """
+    if not LAN_PUSH_URLS:
+        return
+    # same bytes as the REST body of users/{uid}/compact.json
+    body = json.dumps(encode_compact_reading(values))
+    for url in LAN_PUSH_URLS:
+        try:
+            response = requests.post(
+                url,
+                params={"uid": str(uid)},
+                data=body,
+                headers={"Content-Type": "application/json", "X-Push-Token": LAN_PUSH_TOKEN},
+                timeout=LAN_PUSH_TIMEOUT_S,
+            )
+            if response.status_code != 204:
+                logger.warning(f"LAN push to {url} rejected: HTTP {response.status_code} {response.text}")
+            else:
+                logger.debug(f"LAN push to {url}: {body}")
+        except requests.exceptions.RequestException as e:
+            logger.warning(f"LAN push to {url} failed: {e}")
+
+
 def setup():
     """Initialize and setup the EasyView client."""
     logger.info("=" * 60)
@@ -581,6 +718,7 @@ def setup():
 
 def loop(client: EasyViewClient):
     """Execute one monitoring loop iteration."""
+    global last_latest_timestamp
     logger.info("-" * 60)
     logger.info("Starting monitoring loop iteration")
     
@@ -603,6 +741,9 @@ def loop(client: EasyViewClient):
             #"data": prepare_for_firestore(status_data['data'])
         }
         logger.debug(f"Prepared data: glucose={values.get('glucose')}, time={values.get('time')}")
+
+        # Displays on the LAN first: they don't have to wait for the cloud
+        push_compact_to_lan(client.user_id, values)
         
         # Save to Firestore
         logger.info("Saving to Firestore...")
@@ -610,7 +751,13 @@ def loop(client: EasyViewClient):
         
         # Save to Realtime Database
         logger.info("Saving to Realtime Database...")
-        save_to_realtime_db(client.user_id, firestore_data)
+        if values.get("timestamp") != last_latest_timestamp:
+            save_to_realtime_db(client.user_id, firestore_data)
+            last_latest_timestamp = values.get("timestamp")
+        else:
+            logger.info("Reading unchanged, latest left as it is")
+        save_compact_to_realtime_db(client.user_id, values)
+        save_history_to_realtime_db(client.user_id, status_data)
         
         logger.info("Monitoring loop iteration completed successfully")
         return True